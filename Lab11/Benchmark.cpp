@@ -0,0 +1,687 @@
+﻿#include "Benchmark.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GLState.h"
+#include "GpuBackend.h"
+#include "InstancedRenderer.h"
+#include "MeshOptimizer.h"
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "ShaderPipeline.h"
+#include "SimdTrig.h"
+#include "Stroker.h"
+#include "Tessellator.h"
+#include "Triangulator.h"
+#include "UniformBuffers.h"
+#include "UploadStrategy.h"
+#include "VectorPath.h"
+#include "VertexFormat.h"
+
+static const char* benchmarkVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 aInstance;
+    void main() {
+        gl_Position = vec4(aPos + aInstance.xy, 0.0, 1.0);
+    }
+)";
+
+static const char* benchmarkFragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(1.0);
+    }
+)";
+
+static double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// типичный кадр: перенастройка буферов VAO перед каждым рисованием,
+// подкачка небольших порций вершин и пересоздание нескольких объектов
+static double measureBackendFrame(GpuBackend& backend, int frames) {
+    const int drawsPerFrame = 500;
+    const int uploadsPerFrame = 50;
+    const int objectsPerFrame = 5;
+    const size_t chunkBytes = 512;
+
+    setGpuBackend(backend);
+    std::vector<unsigned char> chunk(chunkBytes, 0);
+    unsigned int vertexBuffer = backend.createBuffer(drawsPerFrame * chunkBytes, nullptr, BUFFER_STATIC);
+    unsigned int instanceBuffer = backend.createBuffer(drawsPerFrame * 32, nullptr, BUFFER_STATIC);
+    unsigned int vao = backend.createVertexArray();
+    backend.setVertexDivisor(vao, 1, 1);
+    backend.setVertexAttribute(vao, 0, 0, 2, GL_FLOAT, false, 0);
+    backend.setVertexAttribute(vao, 1, 1, 4, GL_FLOAT, false, 0);
+    backend.setVertexBuffer(vao, 0, vertexBuffer, 0, 2 * sizeof(float));
+
+    double total = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < uploadsPerFrame; i++) {
+            backend.bufferSubData(vertexBuffer, i * chunkBytes, chunkBytes, chunk.data());
+        }
+        for (int i = 0; i < objectsPerFrame; i++) {
+            unsigned int buffer = backend.createBuffer(chunkBytes, chunk.data(), BUFFER_STATIC);
+            unsigned int temporary = backend.createVertexArray();
+            backend.setVertexAttribute(temporary, 0, 0, 2, GL_FLOAT, false, 0);
+            backend.setVertexBuffer(temporary, 0, buffer, 0, 2 * sizeof(float));
+            backend.deleteVertexArray(temporary);
+            backend.deleteBuffer(buffer);
+        }
+        for (int i = 0; i < drawsPerFrame; i++) {
+            backend.setVertexBuffer(vao, 1, instanceBuffer, i * 32, 32);
+            stateBindVertexArray(vao);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 3, 1);
+        }
+
+        total += elapsedMilliseconds(start);
+        // ожидание GPU не входит в замер
+        glFinish();
+    }
+
+    backend.deleteVertexArray(vao);
+    backend.deleteBuffer(vertexBuffer);
+    backend.deleteBuffer(instanceBuffer);
+    return total / frames;
+}
+
+void runBackendBenchmark() {
+    const int frames = 300;
+    GpuBackend& previous = gpuBackend();
+
+    unsigned int program = createShaderProgram(benchmarkVertexShaderSource, benchmarkFragmentShaderSource);
+    stateUseProgram(program);
+
+    std::cout << "Backend benchmark on " << glGetString(GL_RENDERER) << ", " << frames << " frames" << std::endl;
+    double bindTime = measureBackendFrame(bindToEditBackend(), frames);
+    std::cout << "  " << bindToEditBackend().name() << ": " << bindTime << " ms CPU per frame" << std::endl;
+
+    if (isDirectStateAccessSupported()) {
+        double dsaTime = measureBackendFrame(directStateAccessBackend(), frames);
+        std::cout << "  " << directStateAccessBackend().name() << ": " << dsaTime << " ms CPU per frame ("
+            << (bindTime - dsaTime) << " ms difference)" << std::endl;
+    }
+    else {
+        std::cout << "  direct state access is not supported by this context" << std::endl;
+    }
+
+    stateBindVertexArray(0);
+    stateUseProgram(0);
+    stateForgetProgram(program);
+    deleteShaderProgram(program);
+    setGpuBackend(previous);
+}
+
+void runUploadBenchmark() {
+    const int frames = 100;
+    const BufferKind usages[] = { BUFFER_DYNAMIC, BUFFER_STREAM };
+    const char* usageNames[] = { "dynamic (64 x 2 KB per frame)", "stream (3.2 MB per frame)" };
+
+    std::cout << "Upload benchmark, " << frames << " frames" << std::endl;
+    for (int u = 0; u < 2; u++) {
+        std::cout << "  " << usageNames[u] << ":" << std::endl;
+        for (int i = 0; i < UPLOAD_METHOD_COUNT; i++) {
+            UploadMethod method = (UploadMethod)i;
+            double time = measureUploadMethod(method, usages[u], frames);
+            std::cout << "    " << uploadMethodName(method) << ": ";
+            if (time < 0.0) {
+                std::cout << "not supported" << std::endl;
+            }
+            else {
+                std::cout << time << " ms per frame" << std::endl;
+            }
+        }
+    }
+}
+
+// прямой расчет cos/sin для каждой точки, как было в старых построителях фигур
+static int writeReferencePolygon(float* vertices, int sides, float radius) {
+    for (int i = 0; i < sides; i++) {
+        float angle1 = 3.14159f * 2.0f * i / sides;
+        float angle2 = 3.14159f * 2.0f * (i + 1) / sides;
+        vertices[i * 6] = 0.0f;
+        vertices[i * 6 + 1] = 0.0f;
+        vertices[i * 6 + 2] = radius * std::cos(angle1);
+        vertices[i * 6 + 3] = radius * std::sin(angle1);
+        vertices[i * 6 + 4] = radius * std::cos(angle2);
+        vertices[i * 6 + 5] = radius * std::sin(angle2);
+    }
+    return sides * 3;
+}
+
+void runTessellationBenchmark() {
+    const int sides = 64;
+    const int shapes = 200000;
+    std::vector<float> vertices(polygonVertexCount(sides) * 2);
+    // сумма координат не дает компилятору выбросить цикл
+    float checksum = 0.0f;
+
+    auto start = std::chrono::steady_clock::now();
+    long long written = 0;
+    for (int i = 0; i < shapes; i++) {
+        written += writeReferencePolygon(vertices.data(), sides, 0.5f + i * 1e-6f);
+        checksum += vertices[2];
+    }
+    double referenceTime = elapsedMilliseconds(start) * 1e6 / written;
+
+    start = std::chrono::steady_clock::now();
+    written = 0;
+    for (int i = 0; i < shapes; i++) {
+        written += writeRegularPolygon(vertices.data(), sides, 0.0f, 0.0f, 0.5f + i * 1e-6f, 0.0f);
+        checksum += vertices[2];
+    }
+    double tableTime = elapsedMilliseconds(start) * 1e6 / written;
+
+    std::cout << "Tessellation benchmark, " << shapes << " polygons with " << sides << " sides" << std::endl;
+    std::cout << "  cos/sin per vertex: " << referenceTime << " ns per vertex" << std::endl;
+    std::cout << "  trig table: " << tableTime << " ns per vertex (checksum " << checksum << ")" << std::endl;
+}
+
+void runTrigBenchmark() {
+    const int count = 1 << 20;
+    const int repeats = 20;
+    std::vector<float> angles(count);
+    std::vector<float> sines(count);
+    std::vector<float> cosines(count);
+    for (int i = 0; i < count; i++) {
+        angles[i] = -100.0f + 200.0f * i / count;
+    }
+
+    // точность: максимальное отклонение от libm в double; ядро дает около 8e-8,
+    // больше 2e-7 значит ошибку в приведении аргумента или коэффициентах
+    const double errorBound = 2e-7;
+    sincosBatch(angles.data(), sines.data(), cosines.data(), count);
+    double maxError = 0.0;
+    for (int i = 0; i < count; i++) {
+        maxError = std::max(maxError, std::fabs(sines[i] - std::sin((double)angles[i])));
+        maxError = std::max(maxError, std::fabs(cosines[i] - std::cos((double)angles[i])));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (int i = 0; i < count; i++) {
+            sines[i] = std::sin(angles[i]);
+            cosines[i] = std::cos(angles[i]);
+        }
+    }
+    double libmTime = elapsedMilliseconds(start) * 1e6 / ((double)count * repeats);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        sincosBatch(angles.data(), sines.data(), cosines.data(), count);
+    }
+    double batchTime = elapsedMilliseconds(start) * 1e6 / ((double)count * repeats);
+
+    std::cout << "sin/cos benchmark, " << sincosBatchPath() << " path" << std::endl;
+    std::cout << "  max error vs libm on [-100, 100]: " << maxError << " (bound " << errorBound << ")"
+        << (maxError <= errorBound ? "" : " (UNEXPECTED)") << std::endl;
+    std::cout << "  libm: " << libmTime << " ns per angle" << std::endl;
+    std::cout << "  sincosBatch: " << batchTime << " ns per angle (checksum " << sines[count / 3] + cosines[count / 7] << ")" << std::endl;
+
+    // генерация множества повернутых кругов: поворот через libm против пакетного ядра
+    const int circles = 20000;
+    const int sides = 16;
+    std::vector<RegularPolygon> polygons(circles);
+    for (int i = 0; i < circles; i++) {
+        polygons[i].centerX = (i % 200) * 0.01f - 1.0f;
+        polygons[i].centerY = (i / 200) * 0.01f - 1.0f;
+        polygons[i].radius = 0.004f;
+        polygons[i].rotation = i * 0.37f;
+        polygons[i].sides = sides;
+    }
+    std::vector<float> vertices(circles * polygonVertexCount(sides) * 2);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        int written = 0;
+        for (int i = 0; i < circles; i++) {
+            const RegularPolygon& polygon = polygons[i];
+            written += writeRegularPolygon(vertices.data() + written * 2, polygon.sides,
+                polygon.centerX, polygon.centerY, polygon.radius, polygon.rotation);
+        }
+    }
+    double singleTime = elapsedMilliseconds(start) / repeats;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        writeRegularPolygons(vertices.data(), polygons.data(), circles);
+    }
+    double batchPolygonTime = elapsedMilliseconds(start) / repeats;
+
+    std::cout << "  " << circles << " rotated " << sides << "-gons: " << singleTime << " ms one by one, "
+        << batchPolygonTime << " ms batched" << std::endl;
+}
+
+// звездный многоугольник со случайными радиусами и сеткой круглых дыр вокруг центра
+static void buildBenchmarkPolygon(int outline, int holeGrid, std::vector<Contour>& contours) {
+    contours.assign(1, Contour());
+    unsigned int seed = 12345;
+    const TrigTable& table = trigTable(outline);
+    for (int i = 0; i < outline; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float radius = 0.6f + 0.4f * (seed >> 8) / 16777216.0f;
+        contours[0].push_back(radius * table.cosines[i]);
+        contours[0].push_back(radius * table.sines[i]);
+    }
+
+    const int holeSegments = 32;
+    const TrigTable& hole = trigTable(holeSegments);
+    float cell = 0.8f / holeGrid;
+    for (int y = 0; y < holeGrid; y++) {
+        for (int x = 0; x < holeGrid; x++) {
+            float centerX = -0.4f + (x + 0.5f) * cell;
+            float centerY = -0.4f + (y + 0.5f) * cell;
+            Contour contour;
+            for (int i = 0; i < holeSegments; i++) {
+                contour.push_back(centerX + 0.35f * cell * hole.cosines[i]);
+                contour.push_back(centerY + 0.35f * cell * hole.sines[i]);
+            }
+            contours.push_back(contour);
+        }
+    }
+}
+
+void runTriangulationBenchmark() {
+    const int outlines[] = { 10000, 100000, 400000 };
+    const int holeGrid = 10;
+
+    std::cout << "Triangulation benchmark, " << holeGrid * holeGrid << " holes" << std::endl;
+    for (int outline : outlines) {
+        std::vector<Contour> contours;
+        buildBenchmarkPolygon(outline, holeGrid, contours);
+        size_t vertices = 0;
+        for (const Contour& contour : contours) {
+            vertices += contour.size() / 2;
+        }
+
+        IndexedMesh mesh;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = triangulatePolygon(contours, mesh);
+        double time = elapsedMilliseconds(start);
+
+        // у многоугольника с n вершинами и h дырами ровно n + 2h - 2 треугольников
+        size_t expected = vertices + 2 * (contours.size() - 1) - 2;
+        size_t triangles = mesh.indices.size() / 3;
+        std::cout << "  " << vertices << " vertices: " << time << " ms, " << triangles << " triangles"
+            << ((ok && triangles == expected) ? "" : " (UNEXPECTED)") << std::endl;
+    }
+}
+
+void runPathBenchmark() {
+    const int paths = 10000;
+    const float pixelScales[] = { 20.0f, 200.0f, 2000.0f };
+    // окружность единичного радиуса из четырех кубических кривых
+    const float k = 0.5523f;
+    VectorPath path;
+    std::vector<Contour> contours;
+
+    std::cout << "Path flattening benchmark, " << paths << " circles of 4 cubics, 0.25 px tolerance" << std::endl;
+    for (float pixelsPerUnit : pixelScales) {
+        size_t points = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < paths; i++) {
+            float x = (float)(i % 100);
+            float y = (float)(i / 100);
+            clearPath(path);
+            pathMoveTo(path, x + 1.0f, y);
+            pathCubicTo(path, x + 1.0f, y + k, x + k, y + 1.0f, x, y + 1.0f);
+            pathCubicTo(path, x - k, y + 1.0f, x - 1.0f, y + k, x - 1.0f, y);
+            pathCubicTo(path, x - 1.0f, y - k, x - k, y - 1.0f, x, y - 1.0f);
+            pathCubicTo(path, x + k, y - 1.0f, x + 1.0f, y - k, x + 1.0f, y);
+            pathClose(path);
+            flattenPath(path, 0.25f, pixelsPerUnit, contours);
+            points += contours[0].size() / 2;
+        }
+        double time = elapsedMilliseconds(start);
+        std::cout << "  radius " << pixelsPerUnit << " px: " << time * 1000.0 / paths << " us per path, "
+            << points / paths << " points per path" << std::endl;
+    }
+}
+
+void runStrokeBenchmark() {
+    const int contours = 10000;
+    const int points = 64;
+    const char* joinNames[] = { "miter", "round", "bevel" };
+    const TrigTable& table = trigTable(points);
+    std::vector<float> circle;
+    for (int i = 0; i < points; i++) {
+        circle.push_back(table.cosines[i]);
+        circle.push_back(table.sines[i]);
+    }
+    std::vector<StrokeVertex> vertices;
+
+    std::cout << "Stroke benchmark, " << contours << " closed contours of " << points << " points, 8 px wide" << std::endl;
+    for (int join = 0; join < 3; join++) {
+        StrokeStyle style;
+        style.width = 0.02f;
+        style.join = (LineJoin)join;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < contours; i++) {
+            vertices.clear();
+            strokePolyline(circle.data(), points, true, style, 400.0f, vertices);
+        }
+        double time = elapsedMilliseconds(start);
+        std::cout << "  " << joinNames[join] << ": " << time * 1000.0 / contours << " us per contour, "
+            << vertices.size() << " vertices" << std::endl;
+    }
+}
+
+void runVertexFormatBenchmark() {
+    // позиции: круги кэша детализации от 8 до 1024 сегментов и поле экземпляров в NDC
+    std::vector<float> positions;
+    for (int segments = 8; segments <= 1024; segments *= 2) {
+        std::vector<float> circle(polygonVertexCount(segments) * 2);
+        writeRegularPolygon(circle.data(), segments, 0.0f, 0.0f, 1.0f, 0.0f);
+        positions.insert(positions.end(), circle.begin(), circle.end());
+    }
+    int vertexCount = (int)(positions.size() / 2);
+    const float pixelsPerUnit = 1000.0f;  // окно 2000 пикселей
+
+    std::cout << "Vertex format benchmark, " << vertexCount << " positions, error at "
+        << pixelsPerUnit << " px per unit" << std::endl;
+    const AttributeEncoding encodings[] = { ENCODING_FLOAT32, ENCODING_HALF, ENCODING_SNORM16 };
+    for (AttributeEncoding encoding : encodings) {
+        VertexFormat format = positionFormat(encoding);
+        std::vector<unsigned char> encoded(vertexCount * format.stride);
+        auto start = std::chrono::steady_clock::now();
+        encodeAttribute(format, 0, positions.data(), vertexCount, encoded.data());
+        double time = elapsedMilliseconds(start);
+        float error = encodingError(encoding, positions.data(), (int)positions.size());
+        std::cout << "  " << encodingName(encoding) << ": " << format.stride << " bytes per vertex, "
+            << encoded.size() / 1024 << " KB, max error " << error * pixelsPerUnit << " px, "
+            << time * 1e6 / vertexCount << " ns per vertex" << std::endl;
+    }
+
+    // цвета экземпляров в unorm8 вместо четырех float
+    std::vector<float> colors(4096);
+    for (size_t i = 0; i < colors.size(); i++) {
+        colors[i] = (float)((i * 2654435761u) % 10007) / 10006.0f;
+    }
+    const int instances = 102400;
+    const size_t floatColorInstance = 8 * sizeof(float);
+    std::cout << "  instance color unorm8: " << sizeof(PolygonInstance) << " bytes per instance (float color: "
+        << floatColorInstance << "), " << instances * sizeof(PolygonInstance) / 1024 << " KB per frame instead of "
+        << instances * floatColorInstance / 1024 << " KB, max color error "
+        << encodingError(ENCODING_UNORM8, colors.data(), (int)colors.size()) * 255.0f << " / 255" << std::endl;
+}
+
+void runMeshOptimizerBenchmark() {
+    // регулярная сетка с перемешанными треугольниками и вершинами - худший порядок
+    const int cells = 1000;
+    IndexedMesh grid;
+    for (int y = 0; y <= cells; y++) {
+        for (int x = 0; x <= cells; x++) {
+            grid.vertices.push_back((float)x / cells);
+            grid.vertices.push_back((float)y / cells);
+        }
+    }
+    std::vector<uint32_t> triangles;
+    for (int y = 0; y < cells; y++) {
+        for (int x = 0; x < cells; x++) {
+            uint32_t corner = y * (cells + 1) + x;
+            const uint32_t quad[6] = { corner, corner + 1, corner + cells + 2, corner, corner + cells + 2, corner + cells + 1 };
+            triangles.insert(triangles.end(), quad, quad + 6);
+        }
+    }
+    std::mt19937 random(7);
+    std::vector<uint32_t> order(triangles.size() / 3);
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = (uint32_t)i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    std::vector<uint32_t> renumber(grid.vertices.size() / 2);
+    for (size_t i = 0; i < renumber.size(); i++) {
+        renumber[i] = (uint32_t)i;
+    }
+    std::shuffle(renumber.begin(), renumber.end(), random);
+    std::vector<float> shuffledVertices(grid.vertices.size());
+    for (size_t i = 0; i < renumber.size(); i++) {
+        shuffledVertices[renumber[i] * 2] = grid.vertices[i * 2];
+        shuffledVertices[renumber[i] * 2 + 1] = grid.vertices[i * 2 + 1];
+    }
+    grid.vertices.swap(shuffledVertices);
+    for (uint32_t triangle : order) {
+        for (int k = 0; k < 3; k++) {
+            grid.indices.push_back(renumber[triangles[triangle * 3 + k]]);
+        }
+    }
+
+    std::cout << "Mesh optimizer benchmark, " << grid.indices.size() / 3 << " triangles, FIFO cache of "
+        << VERTEX_CACHE_SIZE << std::endl;
+    VertexCacheStats before = analyzeVertexCache(grid);
+    auto start = std::chrono::steady_clock::now();
+    optimizeVertexCache(grid);
+    double cacheTime = elapsedMilliseconds(start);
+    start = std::chrono::steady_clock::now();
+    optimizeVertexFetch(grid);
+    double fetchTime = elapsedMilliseconds(start);
+    VertexCacheStats after = analyzeVertexCache(grid);
+    std::cout << "  ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr
+        << "; triangle order " << cacheTime << " ms, vertex order " << fetchTime << " ms" << std::endl;
+}
+
+// варианты вершинного шейдера с уникальным комментарием: драйвер не возьмет их из собственного кэша
+static std::vector<std::string> saltedVertexSources(int count) {
+    std::string salt = "// " + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "\n";
+    std::vector<std::string> sources;
+    for (int i = 0; i < count; i++) {
+        sources.push_back(std::string(benchmarkVertexShaderSource) + salt + "// variant " + std::to_string(i) + "\n");
+    }
+    return sources;
+}
+
+// собирает программы: по одной с ожиданием каждой или все сразу с ожиданием в конце
+static double buildPrograms(const std::vector<std::string>& vertexSources, bool pipelined) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ProgramHandle> handles;
+    for (const std::string& source : vertexSources) {
+        handles.push_back(submitShaderProgram(source.c_str(), benchmarkFragmentShaderSource));
+        if (!pipelined) {
+            waitShaderProgram(handles.back());
+        }
+    }
+    for (ProgramHandle handle : handles) {
+        waitShaderProgram(handle);
+    }
+    double time = elapsedMilliseconds(start);
+    for (ProgramHandle handle : handles) {
+        deleteShaderProgram(shaderProgramObject(handle));
+    }
+    return time;
+}
+
+void runShaderPipelineBenchmark() {
+    const int programs = 16;
+    double serialTime = buildPrograms(saltedVertexSources(programs), false);
+    double pipelinedTime = buildPrograms(saltedVertexSources(programs), true);
+    std::cout << "Shader pipeline benchmark, " << programs << " programs ("
+        << shaderPipelineModeName()
+        << "): one by one " << serialTime << " ms, submitted together " << pipelinedTime << " ms" << std::endl;
+}
+
+void runProgramCacheBenchmark() {
+    if (!initProgramCache("shader_cache_bench", 4 * 1024 * 1024)) {
+        std::cout << "Program cache benchmark: program binaries are not supported" << std::endl;
+        return;
+    }
+    const int programs = 8;
+    std::vector<std::string> vertexSources = saltedVertexSources(programs);
+    double times[2];
+    for (int pass = 0; pass < 2; pass++) {
+        times[pass] = buildPrograms(vertexSources, true);
+    }
+    const ProgramCacheStats& stats = programCacheStats();
+    std::cout << "Program cache benchmark, " << programs << " programs: cold " << times[0] << " ms (compile and store), warm "
+        << times[1] << " ms (" << stats.loaded << " loaded, " << stats.rejected << " rejected)" << std::endl;
+    shutdownProgramCache();
+}
+
+// константы вызова либо отдельными uniform, либо блоком DrawConstants;
+// строка #version добавляется перед исходником
+static const char* uniformVertexShaderBody = R"(
+    layout (location = 0) in vec2 aPos;
+#ifdef DRAW_CONSTANTS
+    layout (std140) uniform DrawConstants {
+        vec4 uColor;
+        vec4 uTransform;
+    };
+#else
+    uniform vec4 uTransform;
+#endif
+    void main() {
+        gl_Position = vec4(uTransform.xy + uTransform.z * aPos, 0.0, 1.0);
+    }
+)";
+
+static const char* uniformFragmentShaderBody = R"(
+    out vec4 FragColor;
+#ifdef DRAW_CONSTANTS
+    layout (std140) uniform DrawConstants {
+        vec4 uColor;
+        vec4 uTransform;
+    };
+#else
+    uniform vec4 uColor;
+#endif
+    void main() {
+        FragColor = uColor;
+    }
+)";
+
+enum UniformPath {
+    UNIFORM_PATH_QUERY,   // glGetUniformLocation и glUniform4fv на каждый вызов
+    UNIFORM_PATH_CACHED,  // положения из кэша, glUniform4fv на каждый вызов
+    UNIFORM_PATH_RING     // одна загрузка в кольцо, glBindBufferRange на каждый вызов
+};
+
+static double measureUniformPath(UniformPath path, unsigned int program, unsigned int vao, int draws, int frames) {
+    UniformRing ring;
+    if (path == UNIFORM_PATH_RING && !createUniformRing(ring, draws * 256 + 256, UPLOAD_ORPHAN)) {
+        return -1.0;
+    }
+    std::vector<DrawConstants> constants(draws);
+    stateUseProgram(program);
+    stateBindVertexArray(vao);
+
+    double total = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < draws; i++) {
+            DrawConstants& draw = constants[i];
+            draw.color[0] = (float)(i % 7) / 7.0f;
+            draw.color[1] = (float)frame / frames;
+            draw.color[2] = 0.5f;
+            draw.color[3] = 1.0f;
+            draw.transform[0] = -1.0f + 2.0f * (i % 100) / 100.0f;
+            draw.transform[1] = -1.0f + 2.0f * (i / 100 % 100) / 100.0f;
+            draw.transform[2] = 0.01f;
+            draw.transform[3] = 0.0f;
+        }
+        auto start = std::chrono::steady_clock::now();
+
+        if (path == UNIFORM_PATH_RING) {
+            beginUniformFrame(ring);
+            size_t firstOffset;
+            size_t stride;
+            unsigned char* blocks = (unsigned char*)allocateUniformBlocks(ring, sizeof(DrawConstants), draws, firstOffset, stride);
+            for (int i = 0; i < draws; i++) {
+                memcpy(blocks + i * stride, &constants[i], sizeof(DrawConstants));
+            }
+            commitUniformBlocks(ring);
+            for (int i = 0; i < draws; i++) {
+                bindUniformBlock(ring, UNIFORM_DRAW_CONSTANTS, firstOffset + i * stride, sizeof(DrawConstants));
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+            endUniformFrame(ring);
+        }
+        else {
+            for (int i = 0; i < draws; i++) {
+                int colorLocation;
+                int transformLocation;
+                if (path == UNIFORM_PATH_QUERY) {
+                    colorLocation = glGetUniformLocation(program, "uColor");
+                    transformLocation = glGetUniformLocation(program, "uTransform");
+                }
+                else {
+                    colorLocation = uniformLocation(program, "uColor");
+                    transformLocation = uniformLocation(program, "uTransform");
+                }
+                glUniform4fv(colorLocation, 1, constants[i].color);
+                glUniform4fv(transformLocation, 1, constants[i].transform);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+        }
+
+        total += elapsedMilliseconds(start);
+        glFinish();
+    }
+
+    if (path == UNIFORM_PATH_RING) {
+        destroyUniformRing(ring);
+    }
+    return total / frames;
+}
+
+void runUniformBenchmark() {
+    const int draws = 5000;
+    const int frames = 100;
+    std::string vertexSource = std::string("#version 330 core\n") + uniformVertexShaderBody;
+    std::string fragmentSource = std::string("#version 330 core\n") + uniformFragmentShaderBody;
+    std::string blockVertexSource = std::string("#version 330 core\n#define DRAW_CONSTANTS\n") + uniformVertexShaderBody;
+    std::string blockFragmentSource = std::string("#version 330 core\n#define DRAW_CONSTANTS\n") + uniformFragmentShaderBody;
+    ProgramHandle programHandle = submitShaderProgram(vertexSource.c_str(), fragmentSource.c_str());
+    ProgramHandle blockProgramHandle = submitShaderProgram(blockVertexSource.c_str(), blockFragmentSource.c_str());
+    // блок DrawConstants привязывается к своей точке, когда сборка закончена
+    waitShaderProgram(programHandle);
+    waitShaderProgram(blockProgramHandle);
+    unsigned int program = shaderProgramObject(programHandle);
+    unsigned int blockProgram = shaderProgramObject(blockProgramHandle);
+
+    const float triangle[] = { 0.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f };
+    GpuBackend& backend = gpuBackend();
+    unsigned int vertexBuffer = backend.createBuffer(sizeof(triangle), triangle, BUFFER_STATIC);
+    unsigned int vao = backend.createVertexArray();
+    backend.setVertexAttribute(vao, 0, 0, 2, GL_FLOAT, false, 0);
+    backend.setVertexBuffer(vao, 0, vertexBuffer, 0, 2 * sizeof(float));
+
+    double queryTime = measureUniformPath(UNIFORM_PATH_QUERY, program, vao, draws, frames);
+    double cachedTime = measureUniformPath(UNIFORM_PATH_CACHED, program, vao, draws, frames);
+    double ringTime = measureUniformPath(UNIFORM_PATH_RING, blockProgram, vao, draws, frames);
+    std::cout << "Uniform benchmark, " << draws << " draws: glGetUniformLocation per draw " << queryTime
+        << " ms, cached locations " << cachedTime << " ms, std140 ring with glBindBufferRange " << ringTime
+        << " ms CPU per frame" << std::endl;
+
+    stateBindVertexArray(0);
+    stateUseProgram(0);
+    backend.deleteVertexArray(vao);
+    backend.deleteBuffer(vertexBuffer);
+    stateForgetProgram(program);
+    deleteShaderProgram(program);
+    stateForgetProgram(blockProgram);
+    deleteShaderProgram(blockProgram);
+}
+
+void runBenchmarks() {
+    runBackendBenchmark();
+    runUploadBenchmark();
+    runTessellationBenchmark();
+    runTrigBenchmark();
+    runTriangulationBenchmark();
+    runPathBenchmark();
+    runStrokeBenchmark();
+    runVertexFormatBenchmark();
+    runMeshOptimizerBenchmark();
+    runShaderPipelineBenchmark();
+    runProgramCacheBenchmark();
+    runUniformBenchmark();
+}
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+// замеры производительности, запускаются ключом --bench при готовом GL-контексте.
+// Результаты печатаются в консоль.
+
+// время CPU на кадр для бэкендов с привязкой и с прямым доступом к состоянию
+void runBackendBenchmark();
+
+// время кадра для каждого способа загрузки и класса использования
+void runUploadBenchmark();
+
+// наносекунды на вершину при генерации многоугольников через таблицы cos/sin
+void runTessellationBenchmark();
+
+// точность sincosBatch относительно libm и его скорость, в том числе на пакете кругов
+void runTrigBenchmark();
+
+// время триангуляции больших сгенерированных многоугольников с дырами
+void runTriangulationBenchmark();
+
+// построение и разбиение на отрезки путей из кривых Безье при разных масштабах
+void runPathBenchmark();
+
+// генерация обводок замкнутых контуров для каждого вида соединений
+void runStrokeBenchmark();
+
+// размер и ошибка позиций в float, half и snorm16, размер экземпляров с цветом unorm8
+void runVertexFormatBenchmark();
+
+// ACMR/ATVR и время переупорядочения сетки из двух миллионов треугольников
+void runMeshOptimizerBenchmark();
+
+// сборка программ по одной с ожиданием и всех сразу через ShaderPipeline
+void runShaderPipelineBenchmark();
+
+// время создания программ без кэша (сборка и сохранение) и из дискового кэша
+void runProgramCacheBenchmark();
+
+// константы 5000 вызовов: запрос положений, кэш положений, кольцо uniform-буфера
+void runUniformBenchmark();
+
+// все замеры подряд
+void runBenchmarks();
@@ -0,0 +1,383 @@
+﻿#include "GLState.h"
+#include <GL/glew.h>
+#include <unordered_map>
+
+#include "ShaderPipeline.h"
+
+const unsigned int UNKNOWN = 0xFFFFFFFFu;
+const int TRACKED_TEXTURE_UNITS = 16;
+const int TRACKED_UNIFORM_BINDINGS = 16;
+
+// отслеживаемые цели привязки буферов, кроме GL_ELEMENT_ARRAY_BUFFER
+static const GLenum bufferTargets[] = {
+    GL_ARRAY_BUFFER,
+    GL_COPY_READ_BUFFER,
+    GL_COPY_WRITE_BUFFER,
+    GL_DRAW_INDIRECT_BUFFER,
+    GL_UNIFORM_BUFFER,
+    GL_TEXTURE_BUFFER
+};
+const int BUFFER_TARGET_COUNT = sizeof(bufferTargets) / sizeof(bufferTargets[0]);
+
+static const GLenum textureTargets[] = {
+    GL_TEXTURE_2D,
+    GL_TEXTURE_BUFFER
+};
+const int TEXTURE_TARGET_COUNT = sizeof(textureTargets) / sizeof(textureTargets[0]);
+
+struct BufferRange {
+    unsigned int buffer = UNKNOWN;
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+struct StencilOps {
+    unsigned int stencilFail = UNKNOWN;
+    unsigned int depthFail = UNKNOWN;
+    unsigned int depthPass = UNKNOWN;
+};
+
+struct GLStateCache {
+    unsigned int program = UNKNOWN;
+    unsigned int vertexArray = UNKNOWN;
+    unsigned int buffers[BUFFER_TARGET_COUNT];
+    std::unordered_map<unsigned int, unsigned int> elementBuffers;  // VAO -> индексный буфер
+    BufferRange uniformRanges[TRACKED_UNIFORM_BINDINGS];
+    unsigned int activeTexture = UNKNOWN;
+    unsigned int textures[TRACKED_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+    int blend = -1;
+    unsigned int blendSource = UNKNOWN;
+    unsigned int blendDestination = UNKNOWN;
+    int scissorTest = -1;
+    int stencilTest = -1;
+    long long stencilMask = -1;  // -1 - неизвестна, 0xFFFFFFFF - допустимое значение
+    unsigned int stencilFunc = UNKNOWN;
+    int stencilReference = 0;
+    unsigned int stencilFuncMask = 0;
+    StencilOps stencilOps[2];    // GL_FRONT, GL_BACK
+    int colorMask = -1;
+    int viewport[4] = { -1, -1, -1, -1 };
+    int scissor[4] = { -1, -1, -1, -1 };
+    GLStateStats stats;
+};
+
+static GLStateCache cache;
+
+// true, если значение уже установлено; иначе запоминает его
+static bool alreadySet(unsigned int& current, unsigned int value) {
+    if (current == value) {
+        cache.stats.skipped++;
+        return true;
+    }
+    current = value;
+    cache.stats.issued++;
+    return false;
+}
+
+static int bufferTargetIndex(unsigned int target) {
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+        if (bufferTargets[i] == target) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int textureTargetIndex(unsigned int target) {
+    for (int i = 0; i < TEXTURE_TARGET_COUNT; i++) {
+        if (textureTargets[i] == target) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void resetGLState() {
+    GLStateStats stats = cache.stats;
+    cache = GLStateCache();
+    cache.stats = stats;
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+        cache.buffers[i] = UNKNOWN;
+    }
+    for (int unit = 0; unit < TRACKED_TEXTURE_UNITS; unit++) {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; i++) {
+            cache.textures[unit][i] = UNKNOWN;
+        }
+    }
+}
+
+void stateUseProgram(unsigned int program) {
+    if (!alreadySet(cache.program, program)) {
+        // программа из потока сборки должна быть готова до привязки
+        prepareShaderProgram(program);
+        glUseProgram(program);
+    }
+}
+
+void stateBindVertexArray(unsigned int vao) {
+    if (!alreadySet(cache.vertexArray, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void stateBindBuffer(unsigned int target, unsigned int buffer) {
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        // без известного VAO привязку запомнить нельзя
+        if (cache.vertexArray == UNKNOWN) {
+            cache.stats.issued++;
+            glBindBuffer(target, buffer);
+            return;
+        }
+        auto it = cache.elementBuffers.find(cache.vertexArray);
+        if (it == cache.elementBuffers.end()) {
+            it = cache.elementBuffers.emplace(cache.vertexArray, UNKNOWN).first;
+        }
+        if (!alreadySet(it->second, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+        return;
+    }
+
+    int index = bufferTargetIndex(target);
+    if (index < 0) {
+        cache.stats.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (!alreadySet(cache.buffers[index], buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void stateBindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size) {
+    if (target == GL_UNIFORM_BUFFER && index < TRACKED_UNIFORM_BINDINGS) {
+        BufferRange& range = cache.uniformRanges[index];
+        if (range.buffer == buffer && range.offset == offset && range.size == size) {
+            cache.stats.skipped++;
+            return;
+        }
+        range.buffer = buffer;
+        range.offset = offset;
+        range.size = size;
+        // glBindBufferRange меняет и общую привязку цели
+        cache.buffers[bufferTargetIndex(GL_UNIFORM_BUFFER)] = buffer;
+    }
+    cache.stats.issued++;
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void stateBindTexture(unsigned int unit, unsigned int target, unsigned int texture) {
+    int index = textureTargetIndex(target);
+    if (index >= 0 && unit < TRACKED_TEXTURE_UNITS && cache.textures[unit][index] == texture) {
+        cache.stats.skipped++;
+        return;
+    }
+    if (!alreadySet(cache.activeTexture, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    if (index >= 0 && unit < TRACKED_TEXTURE_UNITS) {
+        cache.textures[unit][index] = texture;
+    }
+    cache.stats.issued++;
+    glBindTexture(target, texture);
+}
+
+void stateSetBlend(bool enabled) {
+    int value = enabled ? 1 : 0;
+    if (cache.blend == value) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.blend = value;
+    cache.stats.issued++;
+    if (enabled) {
+        glEnable(GL_BLEND);
+    }
+    else {
+        glDisable(GL_BLEND);
+    }
+}
+
+void stateSetBlendFunc(unsigned int source, unsigned int destination) {
+    if (cache.blendSource == source && cache.blendDestination == destination) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.blendSource = source;
+    cache.blendDestination = destination;
+    cache.stats.issued++;
+    glBlendFunc(source, destination);
+}
+
+static bool sameRect(const int* rect, int x, int y, int width, int height) {
+    return rect[0] == x && rect[1] == y && rect[2] == width && rect[3] == height;
+}
+
+void stateSetViewport(int x, int y, int width, int height) {
+    if (sameRect(cache.viewport, x, y, width, height)) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.viewport[0] = x;
+    cache.viewport[1] = y;
+    cache.viewport[2] = width;
+    cache.viewport[3] = height;
+    cache.stats.issued++;
+    glViewport(x, y, width, height);
+}
+
+void stateSetScissorTest(bool enabled) {
+    int value = enabled ? 1 : 0;
+    if (cache.scissorTest == value) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.scissorTest = value;
+    cache.stats.issued++;
+    if (enabled) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void stateSetStencilTest(bool enabled) {
+    int value = enabled ? 1 : 0;
+    if (cache.stencilTest == value) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.stencilTest = value;
+    cache.stats.issued++;
+    if (enabled) {
+        glEnable(GL_STENCIL_TEST);
+    }
+    else {
+        glDisable(GL_STENCIL_TEST);
+    }
+}
+
+void stateSetStencilMask(unsigned int mask) {
+    if (cache.stencilMask == (long long)mask) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.stencilMask = mask;
+    cache.stats.issued++;
+    glStencilMask(mask);
+}
+
+void stateSetStencilFunc(unsigned int func, int reference, unsigned int mask) {
+    if (cache.stencilFunc == func && cache.stencilReference == reference && cache.stencilFuncMask == mask) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.stencilFunc = func;
+    cache.stencilReference = reference;
+    cache.stencilFuncMask = mask;
+    cache.stats.issued++;
+    glStencilFunc(func, reference, mask);
+}
+
+static bool sameStencilOps(const StencilOps& ops, unsigned int stencilFail, unsigned int depthFail, unsigned int depthPass) {
+    return ops.stencilFail == stencilFail && ops.depthFail == depthFail && ops.depthPass == depthPass;
+}
+
+void stateSetStencilOp(unsigned int face, unsigned int stencilFail, unsigned int depthFail, unsigned int depthPass) {
+    bool front = face != GL_BACK;
+    bool back = face != GL_FRONT;
+    if ((!front || sameStencilOps(cache.stencilOps[0], stencilFail, depthFail, depthPass))
+        && (!back || sameStencilOps(cache.stencilOps[1], stencilFail, depthFail, depthPass))) {
+        cache.stats.skipped++;
+        return;
+    }
+    StencilOps ops;
+    ops.stencilFail = stencilFail;
+    ops.depthFail = depthFail;
+    ops.depthPass = depthPass;
+    if (front) {
+        cache.stencilOps[0] = ops;
+    }
+    if (back) {
+        cache.stencilOps[1] = ops;
+    }
+    cache.stats.issued++;
+    glStencilOpSeparate(face, stencilFail, depthFail, depthPass);
+}
+
+void stateSetColorMask(bool enabled) {
+    int value = enabled ? 1 : 0;
+    if (cache.colorMask == value) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.colorMask = value;
+    cache.stats.issued++;
+    GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+    glColorMask(mask, mask, mask, mask);
+}
+
+void stateSetScissor(int x, int y, int width, int height) {
+    if (sameRect(cache.scissor, x, y, width, height)) {
+        cache.stats.skipped++;
+        return;
+    }
+    cache.scissor[0] = x;
+    cache.scissor[1] = y;
+    cache.scissor[2] = width;
+    cache.scissor[3] = height;
+    cache.stats.issued++;
+    glScissor(x, y, width, height);
+}
+
+void stateForgetProgram(unsigned int program) {
+    if (cache.program == program) {
+        cache.program = UNKNOWN;
+    }
+}
+
+void stateForgetVertexArray(unsigned int vao) {
+    // удаление привязанного VAO возвращает привязку к 0
+    if (cache.vertexArray == vao) {
+        cache.vertexArray = 0;
+    }
+    cache.elementBuffers.erase(vao);
+}
+
+void stateForgetBuffer(unsigned int buffer) {
+    // удаление буфера отвязывает его от всех целей текущего контекста
+    for (int i = 0; i < BUFFER_TARGET_COUNT; i++) {
+        if (cache.buffers[i] == buffer) {
+            cache.buffers[i] = 0;
+        }
+    }
+    for (auto& entry : cache.elementBuffers) {
+        if (entry.second == buffer) {
+            entry.second = UNKNOWN;
+        }
+    }
+    for (int i = 0; i < TRACKED_UNIFORM_BINDINGS; i++) {
+        if (cache.uniformRanges[i].buffer == buffer) {
+            cache.uniformRanges[i] = BufferRange();
+        }
+    }
+}
+
+void stateForgetTexture(unsigned int texture) {
+    for (int unit = 0; unit < TRACKED_TEXTURE_UNITS; unit++) {
+        for (int i = 0; i < TEXTURE_TARGET_COUNT; i++) {
+            if (cache.textures[unit][i] == texture) {
+                cache.textures[unit][i] = 0;
+            }
+        }
+    }
+}
+
+const GLStateStats& glStateStats() {
+    return cache.stats;
+}
+
+void resetGLStateStats() {
+    cache.stats = GLStateStats();
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <cstddef>
+
+// кэш состояния GL перед вызовами привязки: повторная установка уже
+// действующего значения отбрасывается. Все привязки программ, VAO, буферов
+// и текстур в проекте должны идти через эти функции, иначе кэш разойдется
+// с драйвером; после стороннего кода нужно вызвать resetGLState().
+struct GLStateStats {
+    long long issued = 0;   // вызовов, дошедших до драйвера
+    long long skipped = 0;  // отброшенных повторных вызовов
+};
+
+// делает все запомненное состояние неизвестным
+void resetGLState();
+
+void stateUseProgram(unsigned int program);
+void stateBindVertexArray(unsigned int vao);
+// GL_ELEMENT_ARRAY_BUFFER запоминается отдельно для каждого VAO
+void stateBindBuffer(unsigned int target, unsigned int buffer);
+void stateBindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size);
+void stateBindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+
+void stateSetBlend(bool enabled);
+void stateSetBlendFunc(unsigned int source, unsigned int destination);
+void stateSetViewport(int x, int y, int width, int height);
+void stateSetScissorTest(bool enabled);
+void stateSetScissor(int x, int y, int width, int height);
+void stateSetStencilTest(bool enabled);
+// маска записи и функция трафарета общие для обеих сторон
+void stateSetStencilMask(unsigned int mask);
+void stateSetStencilFunc(unsigned int func, int reference, unsigned int mask);
+// face - GL_FRONT, GL_BACK или GL_FRONT_AND_BACK; стороны запоминаются отдельно
+void stateSetStencilOp(unsigned int face, unsigned int stencilFail, unsigned int depthFail, unsigned int depthPass);
+// запись во все каналы цвета сразу включается или выключается
+void stateSetColorMask(bool enabled);
+
+// вызываются при удалении объектов: имя может быть выдано заново
+void stateForgetProgram(unsigned int program);
+void stateForgetVertexArray(unsigned int vao);
+void stateForgetBuffer(unsigned int buffer);
+void stateForgetTexture(unsigned int texture);
+
+const GLStateStats& glStateStats();
+void resetGLStateStats();
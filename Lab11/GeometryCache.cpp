@@ -0,0 +1,96 @@
+﻿#include "GeometryCache.h"
+
+// начальная емкость арены, дальше она растет по мере надобности
+const size_t INITIAL_ARENA_VERTICES = 64 * 1024;
+const size_t INITIAL_ARENA_INDEX_BYTES = 256 * 1024;
+
+void createGeometryCache(GeometryCache& cache, AttributeEncoding positionEncoding) {
+    createVertexArena(cache.arena, positionFormat(positionEncoding), INITIAL_ARENA_VERTICES, INITIAL_ARENA_INDEX_BYTES);
+}
+
+void beginCacheFrame(GeometryCache& cache) {
+    cache.frame = GeometryCacheStats();
+}
+
+const CachedShape* findCachedShape(GeometryCache& cache, const std::string& name) {
+    auto it = cache.shapes.find(name);
+    if (it == cache.shapes.end()) {
+        return nullptr;
+    }
+    cache.frame.hits++;
+    cache.total.hits++;
+    return &it->second;
+}
+
+const CachedShape& cacheIndexedMesh(GeometryCache& cache, const std::string& name, const IndexedMesh& source, int arrayVertexCount) {
+    IndexedMesh mesh = source;
+    VertexCacheReport vertexCache = optimizeMesh(mesh);
+    std::vector<unsigned char> indices = packMeshIndices(mesh);
+    size_t bytes = meshVertexCount(mesh) * cache.arena.vertexStride + indices.size();
+
+    cache.frame.misses++;
+    cache.total.misses++;
+    cache.frame.bytesUploaded += bytes;
+    cache.total.bytesUploaded += bytes;
+
+    CachedShape shape;
+    shape.vertexCount = meshVertexCount(mesh);
+    shape.indexCount = (int)mesh.indices.size();
+    shape.savings = measureIndexedSavings(arrayVertexCount, mesh);
+    shape.savings.indexedBytes = bytes;
+    shape.vertexCache = vertexCache;
+
+    // позиции переводятся в формат арены
+    const VertexFormat& format = cache.arena.format;
+    std::vector<unsigned char> vertices(shape.vertexCount * format.stride);
+    encodeAttribute(format, 0, mesh.vertices.data(), shape.vertexCount, vertices.data());
+    float error = encodingError(format.attributes[0].encoding, mesh.vertices.data(), (int)mesh.vertices.size());
+    cache.maxPositionError = error > cache.maxPositionError ? error : cache.maxPositionError;
+
+    shape.range = arenaAllocate(cache.arena, vertices.data(), shape.vertexCount,
+        indices.data(), mesh.indices.size(), meshIndexSize(mesh));
+    return cache.shapes[name] = shape;
+}
+
+const CachedShape& cacheShapeVertices(GeometryCache& cache, const std::string& name, const float* vertices, int vertexCount) {
+    // убираем повторы и загружаем вершины один раз
+    IndexedMesh mesh = buildIndexedMesh(vertices, vertexCount);
+    return cacheIndexedMesh(cache, name, mesh, vertexCount);
+}
+
+const CachedShape& getCachedShape(GeometryCache& cache, const std::string& name, ShapeBuilder builder) {
+    const CachedShape* cached = findCachedShape(cache, name);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    // промах: строим вершины и загружаем их
+    int vertexCount = 0;
+    const float* vertices = builder(vertexCount);
+    return cacheShapeVertices(cache, name, vertices, vertexCount);
+}
+
+void bindGeometryCache(const GeometryCache& cache) {
+    bindVertexArena(cache.arena);
+}
+
+void drawCachedShape(GeometryCache& cache, const std::string& name, ShapeBuilder builder) {
+    const CachedShape& shape = getCachedShape(cache, name, builder);
+    if (shape.range != INVALID_ARENA_HANDLE) {
+        drawArenaRange(cache.arena, shape.range);
+    }
+}
+
+void evictCachedShape(GeometryCache& cache, const std::string& name) {
+    auto it = cache.shapes.find(name);
+    if (it == cache.shapes.end()) {
+        return;
+    }
+    arenaFree(cache.arena, it->second.range);
+    cache.shapes.erase(it);
+}
+
+void destroyGeometryCache(GeometryCache& cache) {
+    destroyVertexArena(cache.arena);
+    cache.shapes.clear();
+}
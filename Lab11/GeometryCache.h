@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "IndexedMesh.h"
+#include "MeshOptimizer.h"
+#include "VertexArena.h"
+#include "VertexFormat.h"
+
+// функция, которая строит вершины фигуры (createQuadVertices и т.п.)
+typedef const float* (*ShapeBuilder)(int& vertexCount);
+
+// фигура, один раз загруженная в видеопамять: индексированный участок общей арены
+struct CachedShape {
+    ArenaHandle range = INVALID_ARENA_HANDLE;
+    int vertexCount = 0;
+    int indexCount = 0;
+    IndexedSavings savings;  // выигрыш от индексации по сравнению с массивом треугольников
+    VertexCacheReport vertexCache;  // ACMR/ATVR до и после переупорядочения
+};
+
+// статистика обращений к кэшу
+struct GeometryCacheStats {
+    int hits = 0;
+    int misses = 0;
+    size_t bytesUploaded = 0;
+};
+
+struct GeometryCache {
+    VertexArena arena;
+    std::unordered_map<std::string, CachedShape> shapes;
+    GeometryCacheStats frame;  // текущий кадр
+    GeometryCacheStats total;  // за все время работы
+    float maxPositionError = 0.0f;  // наибольшая ошибка кодирования позиций среди загруженных фигур
+};
+
+// позиции фигур хранятся в кодировке positionEncoding (float, half или snorm16);
+// snorm16 подходит фигурам в пределах [-1, 1], остальное обрезается
+void createGeometryCache(GeometryCache& cache, AttributeEncoding positionEncoding);
+
+// сбрасывает покадровую статистику, вызывается в начале кадра
+void beginCacheFrame(GeometryCache& cache);
+
+// возвращает фигуру из кэша, при первом обращении строит и загружает ее
+const CachedShape& getCachedShape(GeometryCache& cache, const std::string& name, ShapeBuilder builder);
+
+// фигура из кэша или nullptr; попадание учитывается в статистике
+const CachedShape* findCachedShape(GeometryCache& cache, const std::string& name);
+
+// загружает уже построенный массив треугольников под именем name (промах в статистике);
+// для фигур с параметрами, которые нельзя передать через ShapeBuilder
+const CachedShape& cacheShapeVertices(GeometryCache& cache, const std::string& name, const float* vertices, int vertexCount);
+
+// загружает готовую индексированную сетку (например, из triangulatePolygon);
+// треугольники и вершины перед загрузкой переупорядочиваются под кэш вершин.
+// arrayVertexCount - сколько вершин заняла бы та же сетка массивом треугольников
+const CachedShape& cacheIndexedMesh(GeometryCache& cache, const std::string& name, const IndexedMesh& mesh, int arrayVertexCount);
+
+// привязывает общий VAO арены; после этого фигуры рисуются без смены VAO
+void bindGeometryCache(const GeometryCache& cache);
+void drawCachedShape(GeometryCache& cache, const std::string& name, ShapeBuilder builder);
+
+// выгружает фигуру; ее участок возвращается в список свободных
+void evictCachedShape(GeometryCache& cache, const std::string& name);
+
+void destroyGeometryCache(GeometryCache& cache);
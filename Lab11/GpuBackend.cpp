@@ -0,0 +1,314 @@
+﻿#include "GpuBackend.h"
+#include <GL/glew.h>
+#include <unordered_map>
+
+#include "GLState.h"
+
+const int MAX_VERTEX_BINDINGS = 8;
+const int MAX_VERTEX_ATTRIBUTES = 16;
+
+static GLenum bufferUsage(BufferKind kind) {
+    switch (kind) {
+    case BUFFER_DYNAMIC:
+        return GL_DYNAMIC_DRAW;
+    case BUFFER_STREAM:
+        return GL_STREAM_DRAW;
+    default:
+        return GL_STATIC_DRAW;
+    }
+}
+
+// ядро 3.3: каждый объект привязывается перед изменением.
+// Буферы правятся через GL_COPY_WRITE_BUFFER, чтобы не задевать привязки VAO;
+// изменяемый VAO остается привязанным.
+// Точки привязки вершинных буферов эмулируются через glVertexAttribPointer.
+class BindToEditBackend : public GpuBackend {
+    struct VertexBinding {
+        unsigned int buffer = 0;
+        size_t offset = 0;
+        int stride = 0;
+        unsigned int divisor = 0;
+    };
+    struct VertexAttribute {
+        bool enabled = false;
+        unsigned int binding = 0;
+        int components = 0;
+        unsigned int type = 0;
+        bool normalized = false;
+        unsigned int relativeOffset = 0;
+    };
+    struct VertexArrayState {
+        VertexBinding bindings[MAX_VERTEX_BINDINGS];
+        VertexAttribute attributes[MAX_VERTEX_ATTRIBUTES];
+    };
+    std::unordered_map<unsigned int, VertexArrayState> vertexArrays;
+
+    void specifyAttribute(const VertexBinding& binding, unsigned int index, const VertexAttribute& attribute) {
+        if (binding.buffer == 0) {
+            return;
+        }
+        stateBindBuffer(GL_ARRAY_BUFFER, binding.buffer);
+        glVertexAttribPointer(index, attribute.components, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE,
+            binding.stride, (void*)(binding.offset + attribute.relativeOffset));
+    }
+
+public:
+    const char* name() const override {
+        return "bind-to-edit (GL 3.3)";
+    }
+
+    unsigned int createBuffer(size_t size, const void* data, BufferKind kind) override {
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, bufferUsage(kind));
+        return buffer;
+    }
+
+    unsigned int createPersistentBuffer(size_t size, void** mapped) override {
+        *mapped = nullptr;
+        if (!GLEW_ARB_buffer_storage) {
+            return 0;
+        }
+        unsigned int buffer;
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &buffer);
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+        *mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+        if (!*mapped) {
+            stateForgetBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+            return 0;
+        }
+        return buffer;
+    }
+
+    void deleteBuffer(unsigned int buffer) override {
+        stateForgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+
+    void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data) override {
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+
+    void copyBufferSubData(unsigned int source, unsigned int destination,
+        size_t sourceOffset, size_t destinationOffset, size_t size) override {
+        stateBindBuffer(GL_COPY_READ_BUFFER, source);
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+    }
+
+    void* mapBufferRange(unsigned int buffer, size_t offset, size_t size, unsigned int access) override {
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access);
+    }
+
+    void unmapBuffer(unsigned int buffer) override {
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+
+    unsigned int createTextureBuffer(unsigned int buffer, unsigned int format) override {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        stateBindTexture(0, GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        return texture;
+    }
+
+    unsigned int createVertexArray() override {
+        unsigned int vao;
+        glGenVertexArrays(1, &vao);
+        vertexArrays[vao] = VertexArrayState();
+        return vao;
+    }
+
+    void deleteVertexArray(unsigned int vao) override {
+        stateForgetVertexArray(vao);
+        glDeleteVertexArrays(1, &vao);
+        vertexArrays.erase(vao);
+    }
+
+    void setVertexBuffer(unsigned int vao, unsigned int binding, unsigned int buffer,
+        size_t offset, int stride) override {
+        VertexArrayState& state = vertexArrays[vao];
+        VertexBinding& target = state.bindings[binding];
+        target.buffer = buffer;
+        target.offset = offset;
+        target.stride = stride;
+
+        stateBindVertexArray(vao);
+        for (unsigned int i = 0; i < MAX_VERTEX_ATTRIBUTES; i++) {
+            const VertexAttribute& attribute = state.attributes[i];
+            if (attribute.enabled && attribute.binding == binding) {
+                specifyAttribute(target, i, attribute);
+            }
+        }
+    }
+
+    void setVertexAttribute(unsigned int vao, unsigned int attribute, unsigned int binding,
+        int components, unsigned int type, bool normalized, unsigned int relativeOffset) override {
+        VertexArrayState& state = vertexArrays[vao];
+        VertexAttribute& target = state.attributes[attribute];
+        target.enabled = true;
+        target.binding = binding;
+        target.components = components;
+        target.type = type;
+        target.normalized = normalized;
+        target.relativeOffset = relativeOffset;
+
+        stateBindVertexArray(vao);
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, state.bindings[binding].divisor);
+        specifyAttribute(state.bindings[binding], attribute, target);
+    }
+
+    void setVertexDivisor(unsigned int vao, unsigned int binding, unsigned int divisor) override {
+        VertexArrayState& state = vertexArrays[vao];
+        state.bindings[binding].divisor = divisor;
+
+        stateBindVertexArray(vao);
+        for (unsigned int i = 0; i < MAX_VERTEX_ATTRIBUTES; i++) {
+            if (state.attributes[i].enabled && state.attributes[i].binding == binding) {
+                glVertexAttribDivisor(i, divisor);
+            }
+        }
+    }
+
+    void setElementBuffer(unsigned int vao, unsigned int buffer) override {
+        stateBindVertexArray(vao);
+        stateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    }
+};
+
+// GL 4.5: объекты меняются по имени, без привязок
+class DirectStateAccessBackend : public GpuBackend {
+public:
+    const char* name() const override {
+        return "direct state access (GL 4.5)";
+    }
+
+    unsigned int createBuffer(size_t size, const void* data, BufferKind kind) override {
+        unsigned int buffer;
+        glCreateBuffers(1, &buffer);
+        if (kind == BUFFER_STATIC) {
+            // неизменяемое хранилище; обновления только через glNamedBufferSubData
+            glNamedBufferStorage(buffer, size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+        else {
+            // изменяемое хранилище, чтобы работало переразмещение через glNamedBufferData
+            glNamedBufferData(buffer, size, data, bufferUsage(kind));
+        }
+        return buffer;
+    }
+
+    unsigned int createPersistentBuffer(size_t size, void** mapped) override {
+        unsigned int buffer;
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, size, nullptr, flags);
+        *mapped = glMapNamedBufferRange(buffer, 0, size, flags);
+        if (!*mapped) {
+            stateForgetBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+            return 0;
+        }
+        return buffer;
+    }
+
+    void deleteBuffer(unsigned int buffer) override {
+        stateForgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+
+    void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data) override {
+        glNamedBufferSubData(buffer, offset, size, data);
+    }
+
+    void copyBufferSubData(unsigned int source, unsigned int destination,
+        size_t sourceOffset, size_t destinationOffset, size_t size) override {
+        glCopyNamedBufferSubData(source, destination, sourceOffset, destinationOffset, size);
+    }
+
+    void* mapBufferRange(unsigned int buffer, size_t offset, size_t size, unsigned int access) override {
+        return glMapNamedBufferRange(buffer, offset, size, access);
+    }
+
+    void unmapBuffer(unsigned int buffer) override {
+        glUnmapNamedBuffer(buffer);
+    }
+
+    unsigned int createTextureBuffer(unsigned int buffer, unsigned int format) override {
+        unsigned int texture;
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &texture);
+        glTextureBuffer(texture, format, buffer);
+        return texture;
+    }
+
+    unsigned int createVertexArray() override {
+        unsigned int vao;
+        glCreateVertexArrays(1, &vao);
+        return vao;
+    }
+
+    void deleteVertexArray(unsigned int vao) override {
+        stateForgetVertexArray(vao);
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    void setVertexBuffer(unsigned int vao, unsigned int binding, unsigned int buffer,
+        size_t offset, int stride) override {
+        glVertexArrayVertexBuffer(vao, binding, buffer, (GLintptr)offset, stride);
+    }
+
+    void setVertexAttribute(unsigned int vao, unsigned int attribute, unsigned int binding,
+        int components, unsigned int type, bool normalized, unsigned int relativeOffset) override {
+        glEnableVertexArrayAttrib(vao, attribute);
+        glVertexArrayAttribFormat(vao, attribute, components, type, normalized ? GL_TRUE : GL_FALSE, relativeOffset);
+        glVertexArrayAttribBinding(vao, attribute, binding);
+    }
+
+    void setVertexDivisor(unsigned int vao, unsigned int binding, unsigned int divisor) override {
+        glVertexArrayBindingDivisor(vao, binding, divisor);
+    }
+
+    void setElementBuffer(unsigned int vao, unsigned int buffer) override {
+        glVertexArrayElementBuffer(vao, buffer);
+    }
+};
+
+static BindToEditBackend bindToEdit;
+static DirectStateAccessBackend directStateAccess;
+static GpuBackend* currentBackend = &bindToEdit;
+
+bool isDirectStateAccessSupported() {
+    return GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+}
+
+void selectGpuBackend(bool allowDirectStateAccess) {
+    if (allowDirectStateAccess && isDirectStateAccessSupported()) {
+        currentBackend = &directStateAccess;
+    }
+    else {
+        currentBackend = &bindToEdit;
+    }
+}
+
+GpuBackend& gpuBackend() {
+    return *currentBackend;
+}
+
+GpuBackend& bindToEditBackend() {
+    return bindToEdit;
+}
+
+GpuBackend& directStateAccessBackend() {
+    return directStateAccess;
+}
+
+void setGpuBackend(GpuBackend& backend) {
+    currentBackend = &backend;
+}
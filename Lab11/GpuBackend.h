@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstddef>
+
+// как буфер будет обновляться
+enum BufferKind {
+    BUFFER_STATIC,   // заполняется при создании и изредка через bufferSubData
+    BUFFER_DYNAMIC,  // часто переписывается, допускает переразмещение (orphaning)
+    BUFFER_STREAM    // переписывается каждый кадр через отображение
+};
+
+// создание и изменение буферов и VAO. Две реализации:
+// привязка для редактирования (ядро 3.3) и прямой доступ к состоянию (DSA, GL 4.5).
+// Вершинные буферы описываются в стиле ARB_vertex_attrib_binding:
+// атрибут ссылается на точку привязки, точка привязки - на буфер со смещением и шагом.
+class GpuBackend {
+public:
+    virtual ~GpuBackend() {}
+    virtual const char* name() const = 0;
+
+    virtual unsigned int createBuffer(size_t size, const void* data, BufferKind kind) = 0;
+    // постоянное когерентное отображение (ARB_buffer_storage); 0, если недоступно
+    virtual unsigned int createPersistentBuffer(size_t size, void** mapped) = 0;
+    virtual void deleteBuffer(unsigned int buffer) = 0;
+    virtual void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data) = 0;
+    virtual void copyBufferSubData(unsigned int source, unsigned int destination,
+        size_t sourceOffset, size_t destinationOffset, size_t size) = 0;
+    // access - флаги glMapBufferRange
+    virtual void* mapBufferRange(unsigned int buffer, size_t offset, size_t size, unsigned int access) = 0;
+    virtual void unmapBuffer(unsigned int buffer) = 0;
+
+    // текстура GL_TEXTURE_BUFFER поверх буфера; format - внутренний формат, например GL_RGBA32F
+    virtual unsigned int createTextureBuffer(unsigned int buffer, unsigned int format) = 0;
+
+    virtual unsigned int createVertexArray() = 0;
+    virtual void deleteVertexArray(unsigned int vao) = 0;
+    virtual void setVertexBuffer(unsigned int vao, unsigned int binding, unsigned int buffer,
+        size_t offset, int stride) = 0;
+    // type - GL_FLOAT, GL_SHORT и т.д.; relativeOffset - смещение атрибута внутри вершины
+    virtual void setVertexAttribute(unsigned int vao, unsigned int attribute, unsigned int binding,
+        int components, unsigned int type, bool normalized, unsigned int relativeOffset) = 0;
+    virtual void setVertexDivisor(unsigned int vao, unsigned int binding, unsigned int divisor) = 0;
+    virtual void setElementBuffer(unsigned int vao, unsigned int buffer) = 0;
+};
+
+// true, если контекст поддерживает GL 4.5 или ARB_direct_state_access
+bool isDirectStateAccessSupported();
+
+// выбирает DSA, если он поддерживается и не запрещен, иначе привязку для редактирования
+void selectGpuBackend(bool allowDirectStateAccess = true);
+
+// текущий выбранный бэкенд
+GpuBackend& gpuBackend();
+
+GpuBackend& bindToEditBackend();
+// только при isDirectStateAccessSupported()
+GpuBackend& directStateAccessBackend();
+void setGpuBackend(GpuBackend& backend);
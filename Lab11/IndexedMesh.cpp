@@ -0,0 +1,70 @@
+﻿#include "IndexedMesh.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+int meshIndexSize(const IndexedMesh& mesh) {
+    return meshVertexCount(mesh) <= 0x10000 ? 2 : 4;
+}
+
+std::vector<unsigned char> packMeshIndices(const IndexedMesh& mesh) {
+    int indexSize = meshIndexSize(mesh);
+    std::vector<unsigned char> bytes(mesh.indices.size() * indexSize);
+    if (indexSize == 4) {
+        memcpy(bytes.data(), mesh.indices.data(), bytes.size());
+        return bytes;
+    }
+    uint16_t* packed = (uint16_t*)bytes.data();
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        packed[i] = (uint16_t)mesh.indices[i];
+    }
+    return bytes;
+}
+
+IndexedMesh buildIndexedMesh(const float* vertices, int vertexCount, float weldEpsilon) {
+    IndexedMesh mesh;
+    mesh.indices.reserve(vertexCount);
+
+    // ключ - координаты, округленные до сетки с шагом weldEpsilon
+    std::unordered_map<uint64_t, uint32_t> lookup;
+    lookup.reserve(vertexCount);
+
+    for (int i = 0; i < vertexCount; i++) {
+        float x = vertices[i * 2];
+        float y = vertices[i * 2 + 1];
+        int32_t qx = (int32_t)std::lround(x / weldEpsilon);
+        int32_t qy = (int32_t)std::lround(y / weldEpsilon);
+        uint64_t key = ((uint64_t)(uint32_t)qx << 32) | (uint32_t)qy;
+
+        auto it = lookup.find(key);
+        if (it != lookup.end()) {
+            mesh.indices.push_back(it->second);
+            continue;
+        }
+        uint32_t index = (uint32_t)(mesh.vertices.size() / 2);
+        mesh.vertices.push_back(x);
+        mesh.vertices.push_back(y);
+        lookup.emplace(key, index);
+        mesh.indices.push_back(index);
+    }
+    return mesh;
+}
+
+IndexedSavings measureIndexedSavings(int arrayVertexCount, const IndexedMesh& mesh) {
+    IndexedSavings savings;
+    savings.arrayVertices = arrayVertexCount;
+    savings.indexedVertices = meshVertexCount(mesh);
+    savings.arrayBytes = arrayVertexCount * 2 * sizeof(float);
+    savings.indexedBytes = mesh.vertices.size() * sizeof(float) + mesh.indices.size() * meshIndexSize(mesh);
+    return savings;
+}
+
+void printIndexedSavings(const char* name, const IndexedSavings& savings) {
+    std::cout << name << ": vertices " << savings.arrayVertices << " -> " << savings.indexedVertices
+        << ", bytes " << savings.arrayBytes << " -> " << savings.indexedBytes;
+    if (savings.arrayBytes > 0) {
+        std::cout << " (" << 100 - (int)(100 * savings.indexedBytes / savings.arrayBytes) << "% less)";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// индексированная сетка: уникальные вершины (пары x, y) и индексы треугольников
+struct IndexedMesh {
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// сколько вершин и байт экономит индексированная сетка по сравнению с массивом треугольников
+struct IndexedSavings {
+    int arrayVertices = 0;
+    int indexedVertices = 0;
+    size_t arrayBytes = 0;
+    size_t indexedBytes = 0;  // вершины + индексы
+};
+
+inline int meshVertexCount(const IndexedMesh& mesh) {
+    return (int)(mesh.vertices.size() / 2);
+}
+
+// 2 байта на индекс, если хватает 16 бит, иначе 4
+int meshIndexSize(const IndexedMesh& mesh);
+
+// упаковывает индексы в 16 или 32 бита (см. meshIndexSize)
+std::vector<unsigned char> packMeshIndices(const IndexedMesh& mesh);
+
+// сваривает совпадающие (с точностью weldEpsilon) вершины массива треугольников
+IndexedMesh buildIndexedMesh(const float* vertices, int vertexCount, float weldEpsilon = 1e-4f);
+
+IndexedSavings measureIndexedSavings(int arrayVertexCount, const IndexedMesh& mesh);
+void printIndexedSavings(const char* name, const IndexedSavings& savings);
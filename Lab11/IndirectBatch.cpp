@@ -0,0 +1,218 @@
+﻿#include "IndirectBatch.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+
+#include "GLState.h"
+
+bool createIndirectBatch(IndirectBatch& batch, size_t maxCommandsPerFrame) {
+    // ненулевой baseInstance в командах учитывается только с ARB_base_instance (ядро 4.2)
+    batch.multiDrawIndirect = (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect)
+        && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+    if (!batch.multiDrawIndirect) {
+        return true;
+    }
+    return createStreamBuffer(batch.commands, GL_DRAW_INDIRECT_BUFFER,
+        maxCommandsPerFrame * sizeof(DrawElementsIndirectCommand));
+}
+
+void destroyIndirectBatch(IndirectBatch& batch) {
+    if (batch.multiDrawIndirect) {
+        destroyStreamBuffer(batch.commands);
+    }
+}
+
+void beginIndirectFrame(IndirectBatch& batch) {
+    if (batch.multiDrawIndirect) {
+        beginStreamFrame(batch.commands);
+    }
+}
+
+void endIndirectFrame(IndirectBatch& batch) {
+    if (batch.multiDrawIndirect) {
+        endStreamFrame(batch.commands);
+    }
+}
+
+void addIndirectDraw(IndirectBatch& batch, const VertexArena& arena, ArenaHandle mesh,
+    unsigned int instanceCount, unsigned int baseInstance) {
+    const ArenaAllocation& allocation = arena.allocations[mesh];
+    if (allocation.indexSize == 0) {
+        DrawArraysIndirectCommand command;
+        command.count = (unsigned int)allocation.vertexCount;
+        command.instanceCount = instanceCount;
+        command.first = (unsigned int)allocation.firstVertex;
+        command.baseInstance = baseInstance;
+        batch.arrays.push_back(command);
+        return;
+    }
+    DrawElementsIndirectCommand command;
+    command.count = (unsigned int)allocation.indexCount;
+    command.instanceCount = instanceCount;
+    command.firstIndex = (unsigned int)(allocation.indexOffset / allocation.indexSize);
+    command.baseVertex = (int)allocation.firstVertex;
+    command.baseInstance = baseInstance;
+    (allocation.indexSize == 2 ? batch.elements16 : batch.elements32).push_back(command);
+}
+
+// все команды рисуют по одному экземпляру с одними и теми же данными
+template <typename Command>
+static bool sharesInstance(const std::vector<Command>& commands) {
+    for (const Command& command : commands) {
+        if (command.instanceCount != 1 || command.baseInstance != commands[0].baseInstance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// порядок сеток для запасного пути; внутри сетки - по baseInstance
+static bool commandOrder(const DrawArraysIndirectCommand& a, const DrawArraysIndirectCommand& b) {
+    if (a.first != b.first) {
+        return a.first < b.first;
+    }
+    if (a.count != b.count) {
+        return a.count < b.count;
+    }
+    return a.baseInstance < b.baseInstance;
+}
+
+static bool commandOrder(const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b) {
+    if (a.firstIndex != b.firstIndex) {
+        return a.firstIndex < b.firstIndex;
+    }
+    if (a.count != b.count) {
+        return a.count < b.count;
+    }
+    if (a.baseVertex != b.baseVertex) {
+        return a.baseVertex < b.baseVertex;
+    }
+    return a.baseInstance < b.baseInstance;
+}
+
+static bool sameMesh(const DrawArraysIndirectCommand& a, const DrawArraysIndirectCommand& b) {
+    return a.first == b.first && a.count == b.count;
+}
+
+static bool sameMesh(const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b) {
+    return a.firstIndex == b.firstIndex && a.count == b.count && a.baseVertex == b.baseVertex;
+}
+
+// сортирует команды по сетке и сливает экземпляры, лежащие в буфере подряд:
+// фигуры одного типа, записанные группой, рисуются одним вызовом
+template <typename Command>
+static std::vector<Command> mergeInstanceRuns(const std::vector<Command>& commands) {
+    std::vector<Command> sorted(commands);
+    std::sort(sorted.begin(), sorted.end(), [](const Command& a, const Command& b) { return commandOrder(a, b); });
+    std::vector<Command> merged;
+    for (const Command& command : sorted) {
+        if (!merged.empty()) {
+            Command& last = merged.back();
+            if (sameMesh(last, command) && last.baseInstance + last.instanceCount == command.baseInstance) {
+                last.instanceCount += command.instanceCount;
+                continue;
+            }
+        }
+        merged.push_back(command);
+    }
+    return merged;
+}
+
+// копирует команды в отображенный буфер и возвращает их смещение
+template <typename Command>
+static bool uploadCommands(IndirectBatch& batch, const std::vector<Command>& commands, size_t& offset) {
+    size_t bytes = commands.size() * sizeof(Command);
+    void* memory = streamAllocate(batch.commands, bytes, sizeof(unsigned int), offset);
+    if (!memory) {
+        return false;
+    }
+    memcpy(memory, commands.data(), bytes);
+    streamCommit(batch.commands);
+    return true;
+}
+
+static void submitArrays(IndirectBatch& batch, InstancedRenderer& renderer, const VertexArena& arena) {
+    const std::vector<DrawArraysIndirectCommand>& commands = batch.arrays;
+    if (commands.empty()) {
+        return;
+    }
+
+    size_t offset;
+    if (batch.multiDrawIndirect && uploadCommands(batch, commands, offset)) {
+        bindInstancedRenderer(renderer, arena, 0);
+        stateBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.commands.buffer);
+        glMultiDrawArraysIndirect(GL_TRIANGLES, (void*)offset, (GLsizei)commands.size(), 0);
+        batch.submitCalls++;
+        return;
+    }
+
+    if (sharesInstance(commands)) {
+        std::vector<GLint> first(commands.size());
+        std::vector<GLsizei> count(commands.size());
+        for (size_t i = 0; i < commands.size(); i++) {
+            first[i] = commands[i].first;
+            count[i] = commands[i].count;
+        }
+        bindInstancedRenderer(renderer, arena, commands[0].baseInstance);
+        glMultiDrawArrays(GL_TRIANGLES, first.data(), count.data(), (GLsizei)commands.size());
+        batch.submitCalls++;
+        return;
+    }
+
+    for (const DrawArraysIndirectCommand& command : mergeInstanceRuns(commands)) {
+        bindInstancedRenderer(renderer, arena, command.baseInstance);
+        glDrawArraysInstanced(GL_TRIANGLES, command.first, command.count, command.instanceCount);
+        batch.submitCalls++;
+    }
+}
+
+static void submitElements(IndirectBatch& batch, InstancedRenderer& renderer, const VertexArena& arena,
+    const std::vector<DrawElementsIndirectCommand>& commands, int indexSize) {
+    if (commands.empty()) {
+        return;
+    }
+    GLenum type = indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    size_t offset;
+    if (batch.multiDrawIndirect && uploadCommands(batch, commands, offset)) {
+        bindInstancedRenderer(renderer, arena, 0);
+        stateBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.commands.buffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, type, (void*)offset, (GLsizei)commands.size(), 0);
+        batch.submitCalls++;
+        return;
+    }
+
+    if (sharesInstance(commands)) {
+        std::vector<GLsizei> count(commands.size());
+        std::vector<const void*> indices(commands.size());
+        std::vector<GLint> baseVertex(commands.size());
+        for (size_t i = 0; i < commands.size(); i++) {
+            count[i] = commands[i].count;
+            indices[i] = (const void*)((size_t)commands[i].firstIndex * indexSize);
+            baseVertex[i] = commands[i].baseVertex;
+        }
+        bindInstancedRenderer(renderer, arena, commands[0].baseInstance);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, count.data(), type, indices.data(),
+            (GLsizei)commands.size(), baseVertex.data());
+        batch.submitCalls++;
+        return;
+    }
+
+    for (const DrawElementsIndirectCommand& command : mergeInstanceRuns(commands)) {
+        bindInstancedRenderer(renderer, arena, command.baseInstance);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, type,
+            (void*)((size_t)command.firstIndex * indexSize), command.instanceCount, command.baseVertex);
+        batch.submitCalls++;
+    }
+}
+
+void submitIndirectBatch(IndirectBatch& batch, InstancedRenderer& renderer, const VertexArena& arena) {
+    batch.submitCalls = 0;
+    submitArrays(batch, renderer, arena);
+    submitElements(batch, renderer, arena, batch.elements16, 2);
+    submitElements(batch, renderer, arena, batch.elements32, 4);
+
+    batch.arrays.clear();
+    batch.elements16.clear();
+    batch.elements32.clear();
+}
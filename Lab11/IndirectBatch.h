@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "InstancedRenderer.h"
+#include "StreamBuffer.h"
+#include "VertexArena.h"
+
+// записи команд в формате, который читает glMultiDraw*Indirect
+struct DrawArraysIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int first;
+    unsigned int baseInstance;
+};
+
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// собирает рисование разнородных фигур из арены в несколько вызовов
+// glMultiDrawArraysIndirect/glMultiDrawElementsIndirect (по одному на тип индексов).
+// На контекстах 3.3 без ARB_multi_draw_indirect или ARB_base_instance команды, которые не различаются
+// данными экземпляров, уходят одним glMultiDrawArrays/glMultiDrawElementsBaseVertex;
+// остальные сортируются по сетке, и команды одной сетки с идущими подряд
+// baseInstance сливаются в один instanced-вызов. Порядок наложения разных
+// сеток при этом не сохраняется.
+struct IndirectBatch {
+    std::vector<DrawArraysIndirectCommand> arrays;
+    std::vector<DrawElementsIndirectCommand> elements16;
+    std::vector<DrawElementsIndirectCommand> elements32;
+    StreamBuffer commands;
+    bool multiDrawIndirect = false;
+    int submitCalls = 0;  // вызовов рисования в последней отправке
+};
+
+bool createIndirectBatch(IndirectBatch& batch, size_t maxCommandsPerFrame);
+void destroyIndirectBatch(IndirectBatch& batch);
+
+void beginIndirectFrame(IndirectBatch& batch);
+void endIndirectFrame(IndirectBatch& batch);
+
+// добавляет рисование участка арены; baseInstance - абсолютный номер
+// экземпляра в потоковом буфере InstancedRenderer
+void addIndirectDraw(IndirectBatch& batch, const VertexArena& arena, ArenaHandle mesh,
+    unsigned int instanceCount = 1, unsigned int baseInstance = 0);
+
+// отправляет накопленные команды и очищает пакет
+void submitIndirectBatch(IndirectBatch& batch, InstancedRenderer& renderer, const VertexArena& arena);
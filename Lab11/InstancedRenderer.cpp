@@ -0,0 +1,116 @@
+﻿#include "InstancedRenderer.h"
+#include <GL/glew.h>
+
+#include "GLState.h"
+#include "GpuBackend.h"
+#include "Shader.h"
+#include "VertexFormat.h"
+
+static const char* instancedVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 aTransform;  // сдвиг xy, масштаб, поворот
+    layout (location = 2) in vec4 aColor;
+    out vec4 vColor;
+    void main() {
+        float c = cos(aTransform.w);
+        float s = sin(aTransform.w);
+        vec2 position = mat2(c, s, -s, c) * (aPos * aTransform.z) + aTransform.xy;
+        gl_Position = vec4(position, 0.0, 1.0);
+        vColor = aColor;
+    }
+)";
+
+static const char* instancedFragmentShaderSource = R"(
+    #version 330 core
+    in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+bool createInstancedRenderer(InstancedRenderer& renderer, size_t maxInstancesPerFrame, UploadMethod uploadMethod) {
+    renderer.program = createShaderProgram(instancedVertexShaderSource, instancedFragmentShaderSource);
+    if (!renderer.program) {
+        return false;
+    }
+    renderer.instances = createUploadStrategy(uploadMethod);
+    if (!renderer.instances->create(GL_ARRAY_BUFFER, maxInstancesPerFrame * sizeof(PolygonInstance))) {
+        return false;
+    }
+
+    // точка привязки 0 - вершины арены в ее формате (задается при привязке арены),
+    // 1 - экземпляры с делителем 1
+    VertexFormat instanceFormat;
+    addFormatAttribute(instanceFormat, 1, 4, ENCODING_FLOAT32);
+    addFormatAttribute(instanceFormat, 2, 4, ENCODING_UNORM8);
+    GpuBackend& backend = gpuBackend();
+    renderer.VAO = backend.createVertexArray();
+    backend.setVertexDivisor(renderer.VAO, 1, 1);
+    applyVertexFormat(renderer.VAO, 1, instanceFormat);
+    return true;
+}
+
+void destroyInstancedRenderer(InstancedRenderer& renderer) {
+    gpuBackend().deleteVertexArray(renderer.VAO);
+    renderer.instances->destroy();
+    delete renderer.instances;
+    renderer.instances = nullptr;
+    stateForgetProgram(renderer.program);
+    deleteShaderProgram(renderer.program);
+    renderer.VAO = 0;
+    renderer.program = 0;
+}
+
+void beginInstancedFrame(InstancedRenderer& renderer) {
+    renderer.instances->beginFrame();
+    renderer.drawCalls = 0;
+}
+
+void endInstancedFrame(InstancedRenderer& renderer) {
+    renderer.instances->endFrame();
+}
+
+PolygonInstance* allocateInstances(InstancedRenderer& renderer, int count, size_t& firstInstance) {
+    size_t offset = 0;
+    void* memory = renderer.instances->allocate(count * sizeof(PolygonInstance), sizeof(PolygonInstance), offset);
+    firstInstance = memory != nullptr ? offset / sizeof(PolygonInstance) : 0;
+    return (PolygonInstance*)memory;
+}
+
+void bindInstancedRenderer(InstancedRenderer& renderer, const VertexArena& arena, size_t firstInstance) {
+    renderer.instances->commit();
+    GpuBackend& backend = gpuBackend();
+
+    // арена могла переехать в новые буферы при уплотнении или росте
+    if (renderer.arenaGeneration != arena.generation) {
+        applyVertexFormat(renderer.VAO, 0, arena.format);
+        backend.setVertexBuffer(renderer.VAO, 0, arena.VBO, 0, (int)arena.vertexStride);
+        backend.setElementBuffer(renderer.VAO, arena.EBO);
+        renderer.arenaGeneration = arena.generation;
+    }
+
+    // без ARB_base_instance начало данных экземпляров задается смещением буфера
+    backend.setVertexBuffer(renderer.VAO, 1, renderer.instances->buffer(),
+        firstInstance * sizeof(PolygonInstance), sizeof(PolygonInstance));
+
+    stateUseProgram(renderer.program);
+    stateBindVertexArray(renderer.VAO);
+}
+
+void drawInstances(InstancedRenderer& renderer, const VertexArena& arena, ArenaHandle mesh,
+    size_t firstInstance, int count) {
+    bindInstancedRenderer(renderer, arena, firstInstance);
+
+    const ArenaAllocation& allocation = arena.allocations[mesh];
+    if (allocation.indexSize == 0) {
+        glDrawArraysInstanced(GL_TRIANGLES, (GLint)allocation.firstVertex, (GLsizei)allocation.vertexCount, count);
+    }
+    else {
+        GLenum type = allocation.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)allocation.indexCount, type,
+            (void*)allocation.indexOffset, count, (GLint)allocation.firstVertex);
+    }
+    renderer.drawCalls++;
+}
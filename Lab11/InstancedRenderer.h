@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "UploadStrategy.h"
+#include "VertexArena.h"
+
+// атрибуты одного экземпляра фигуры (20 байт)
+struct PolygonInstance {
+    float offsetX, offsetY;  // сдвиг
+    float scale;
+    float rotation;          // угол поворота в радианах
+    uint32_t color;          // unorm8 r, g, b, a (packColorUnorm8)
+};
+
+// рисует много копий одной базовой сетки из арены одним вызовом
+// glDrawElementsInstancedBaseVertex; атрибуты экземпляров загружаются
+// выбранной стратегией (класс BUFFER_STREAM) и читаются с делителем 1
+struct InstancedRenderer {
+    unsigned int program = 0;
+    unsigned int VAO = 0;
+    unsigned int arenaGeneration = 0;  // поколение буферов арены, к которым привязан VAO
+    UploadStrategy* instances = nullptr;
+    int drawCalls = 0;          // вызовы рисования за кадр
+};
+
+bool createInstancedRenderer(InstancedRenderer& renderer, size_t maxInstancesPerFrame, UploadMethod uploadMethod);
+void destroyInstancedRenderer(InstancedRenderer& renderer);
+
+void beginInstancedFrame(InstancedRenderer& renderer);
+void endInstancedFrame(InstancedRenderer& renderer);
+
+// место под count экземпляров в буфере текущего кадра;
+// firstInstance передается затем в drawInstances
+PolygonInstance* allocateInstances(InstancedRenderer& renderer, int count, size_t& firstInstance);
+
+// привязывает программу, VAO и данные экземпляров, начиная с firstInstance
+void bindInstancedRenderer(InstancedRenderer& renderer, const VertexArena& arena, size_t firstInstance);
+
+// рисует count экземпляров базовой сетки mesh, начиная с firstInstance
+void drawInstances(InstancedRenderer& renderer, const VertexArena& arena, ArenaHandle mesh,
+    size_t firstInstance, int count);
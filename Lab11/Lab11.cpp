@@ -2,154 +2,475 @@
 #include <GLFW/glfw3.h>
 #include <cmath>
 #include <iostream>
-
+#include <string>
+
+#include "Benchmark.h"
+#include "GeometryCache.h"
+#include "GLState.h"
+#include "GpuBackend.h"
+#include "IndirectBatch.h"
+#include "InstancedRenderer.h"
+#include "LevelOfDetail.h"
+#include "PolygonPuller.h"
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "ShaderPermutations.h"
+#include "ShaderPipeline.h"
+#include "ShaderWatcher.h"
+#include "StencilFill.h"
+#include "ShapeTables.h"
+#include "StreamBuffer.h"
+#include "Stroker.h"
+#include "Tessellator.h"
+#include "Triangulator.h"
+#include "UniformBuffers.h"
+#include "UploadStrategy.h"
+#include "VectorPath.h"
+#include "VertexFormat.h"
+
+// общие исходники трех видов закрашивания, если в каталоге шейдеров нет
+// shading.vert и shading.frag с тем же текстом; варианты задаются признаками
+// UNIFORM_COLOR, VERTEX_COLOR и DRAW_TRANSFORM (ShaderPermutations.h).
+// Блоки повторяют FrameConstants и DrawConstants из UniformBuffers.h
 const char* vertexShaderSource = R"(
+    #version 330 core
     layout (location = 0) in vec2 aPos;
+#ifdef VERTEX_COLOR
+    layout (location = 1) in vec4 aColor;
+    out vec4 vertexColor;
+#endif
+#ifdef DRAW_TRANSFORM
+    layout (std140) uniform FrameConstants {
+        vec4 uViewport;
+        float uTime;
+    };
+    layout (std140) uniform DrawConstants {
+        vec4 uColor;
+        vec4 uTransform;
+    };
+#endif
     void main() {
+#ifdef DRAW_TRANSFORM
+        // поворот и масштаб фигуры без растяжения вдоль длинной стороны окна
+        float c = cos(uTransform.w);
+        float s = sin(uTransform.w);
+        vec2 local = uTransform.z * vec2(c * aPos.x - s * aPos.y, s * aPos.x + c * aPos.y);
+        vec2 aspect = vec2(min(1.0, uViewport.y * uViewport.z), min(1.0, uViewport.x * uViewport.w));
+        gl_Position = vec4(uTransform.xy + local * aspect, 0.0, 1.0);
+#else
         gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
+#endif
+#ifdef VERTEX_COLOR
+        vertexColor = aColor;
+#endif
     }
 )";
 
 const char* fragmentShaderSource = R"(
+    #version 330 core
     out vec4 FragColor;
+#if defined(VERTEX_COLOR)
+    in vec4 vertexColor;
+#elif defined(UNIFORM_COLOR)
+    layout (std140) uniform DrawConstants {
+        vec4 uColor;
+        vec4 uTransform;
+    };
+#endif
     void main() {
-        FragColor = vec4(1.0, 0.2, 1.0, 1.0); 
+#if defined(VERTEX_COLOR)
+        FragColor = vertexColor;
+#elif defined(UNIFORM_COLOR)
+        FragColor = uColor;
+#else
+        FragColor = vec4(1.0, 0.2, 1.0, 1.0);
+#endif
     }
 )";
 
-unsigned int compileShader(unsigned int type, const char* source) {
-    unsigned int shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cout << "Shader compilation error:\n" << infoLog << std::endl;
-        return 0;
-    }
-    return shader;
+// встроенные фигуры: таблицы вершин посчитаны при компиляции (ShapeTables.h)
+const float* createQuadVertices(int& vertexCount) {
+    vertexCount = shapeTableVertexCount(QUAD_SHAPE);
+    return QUAD_SHAPE.vertices;
+}
+
+const float* createFanVertices(int& vertexCount) {
+    vertexCount = shapeTableVertexCount(FAN_SHAPE);
+    return FAN_SHAPE.vertices;
 }
 
-unsigned int createShaderProgram() {
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+const float* createPentagonVertices(int& vertexCount) {
+    vertexCount = shapeTableVertexCount(PENTAGON_SHAPE);
+    return PENTAGON_SHAPE.vertices;
+}
 
-    if (!vertexShader || !fragmentShader) {
-        return 0;
-    }
+// анимированный веер: вершины пишутся прямо в отображенную память потокового буфера;
+// каждый второй луч короче, чтобы вращение было заметно
+const int ANIMATED_FAN_TRIANGLES = 12;
 
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+int writeAnimatedFanVertices(float* vertices, float time) {
+    float radius = 0.5f + 0.2f * sin(time * 2.0f);
+    return writeStar(vertices, ANIMATED_FAN_TRIANGLES / 2, 0.0f, 0.0f, radius, radius * 0.6f, time);
+}
 
-    int success;
-    char infoLog[512];
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "Program linking error:\n" << infoLog << std::endl;
+// поле из множества фигур: по одному вызову рисования на тип фигуры
+const int INSTANCE_GRID_SIZE = 320;  // 320 x 320 = 102400 фигур
+
+int writeInstanceField(PolygonInstance* instances, int shapeType, float time) {
+    int total = INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE;
+    int count = 0;
+    float cell = 2.0f / INSTANCE_GRID_SIZE;
+
+    // фигуры разных типов чередуются по клеткам сетки
+    for (int k = shapeType; k < total; k += 3) {
+        int x = k % INSTANCE_GRID_SIZE;
+        int y = k / INSTANCE_GRID_SIZE;
+        PolygonInstance& instance = instances[count++];
+        instance.offsetX = -1.0f + (x + 0.5f) * cell;
+        instance.offsetY = -1.0f + (y + 0.5f) * cell;
+        instance.scale = cell;
+        instance.rotation = time + k * 0.01f;
+        instance.color = packColorUnorm8((float)x / INSTANCE_GRID_SIZE, 0.2f + 0.2f * shapeType,
+            (float)y / INSTANCE_GRID_SIZE, 1.0f);
     }
+    return count;
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+int instanceFieldCount(int shapeType) {
+    int total = INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE;
+    return (total - shapeType + 2) / 3;
+}
 
-    return shaderProgram;
+// многоугольники с разным числом сторон (от 3 до PULLED_MAX_SIDES) для режима выборки вершин
+const int PULLED_GRID_SIZE = 100;
+const int PULLED_MAX_SIDES = 10;
+
+int writePolygonRecords(PolygonRecord* records, float time) {
+    float cell = 2.0f / PULLED_GRID_SIZE;
+    int count = 0;
+    for (int y = 0; y < PULLED_GRID_SIZE; y++) {
+        for (int x = 0; x < PULLED_GRID_SIZE; x++) {
+            PolygonRecord& record = records[count++];
+            record.centerX = -1.0f + (x + 0.5f) * cell;
+            record.centerY = -1.0f + (y + 0.5f) * cell;
+            record.radius = cell * 0.45f;
+            record.rotation = time * 0.5f;
+            record.sides = (float)(3 + (x + y) % (PULLED_MAX_SIDES - 2));
+            record.r = 0.3f + 0.7f * x / PULLED_GRID_SIZE;
+            record.g = 0.3f;
+            record.b = 0.3f + 0.7f * y / PULLED_GRID_SIZE;
+        }
+    }
+    return count;
 }
 
-// четырехугольник
-float* createQuadVertices(int& vertexCount) {
-    static float vertices[] = {
-        -0.5f,  0.5f,  // левый верхний
-        -0.5f, -0.5f,  // левый нижний
-         0.5f, -0.5f,  // правый нижний
+// смешанная сцена: фигуры разных типов вперемешку, у каждой свои данные экземпляра.
+// Экземпляры пишутся группами по типу фигуры, чтобы без multi-draw indirect
+// команды одного типа сливались в один instanced-вызов
+const int MIXED_SCENE_SHAPES = 3000;
+
+void writeMixedScene(PolygonInstance* instances, int* shapeTypes, float time) {
+    // простая хеш-функция дает стабильное "случайное" расположение и тип
+    int groupStart[3] = { 0, 0, 0 };
+    for (int i = 0; i < MIXED_SCENE_SHAPES; i++) {
+        unsigned int hash = (unsigned int)i * 2654435761u;
+        int type = (hash >> 7) % 3;
+        for (int next = type + 1; next < 3; next++) {
+            groupStart[next]++;
+        }
+    }
 
-         -0.5f,  0.5f,  // левый верхний
-          0.5f, -0.5f,  // правый нижний
-          0.5f,  0.5f   // правый верхний
-    };
-    vertexCount = 6; 
-    return vertices;
+    for (int i = 0; i < MIXED_SCENE_SHAPES; i++) {
+        unsigned int hash = (unsigned int)i * 2654435761u;
+        float x = (hash & 0xFFFF) / 65535.0f;
+        float y = ((hash >> 16) & 0xFFFF) / 65535.0f;
+
+        int type = (hash >> 7) % 3;
+        int slot = groupStart[type]++;
+        shapeTypes[slot] = type;
+        PolygonInstance& instance = instances[slot];
+        instance.offsetX = x * 1.9f - 0.95f;
+        instance.offsetY = y * 1.9f - 0.95f;
+        instance.scale = 0.03f + 0.02f * x;
+        instance.rotation = time * (0.5f + y);
+        instance.color = packColorUnorm8(0.4f + 0.6f * x, 0.4f + 0.2f * type, 0.4f + 0.6f * y, 1.0f);
+    }
 }
 
-// веер
-float* createFanVertices(int& vertexCount) {
-    static float vertices[8 * 3 * 2]; 
-    float centerX = 0.0f;
-    float centerY = 0.0f;
-    float radius = 0.7f;
-    int triangles = 8;
+// круги, которые приближаются и удаляются в 1000 раз; детализация каждого
+// выбирается по его радиусу на экране. Радиусы дублируются в radii, чтобы
+// не читать обратно из отображенной памяти буфера экземпляров
+const int ZOOM_CIRCLES = 4;
+
+void writeZoomCircles(PolygonInstance* instances, float* radii, float time) {
+    for (int i = 0; i < ZOOM_CIRCLES; i++) {
+        float phase = time * 0.7f + i * 1.6f;
+        PolygonInstance& instance = instances[i];
+        instance.offsetX = -0.6f + 0.4f * i;
+        instance.offsetY = 0.0f;
+        // радиус от 0.001 до 1 в координатах NDC
+        radii[i] = 0.001f * pow(1000.0f, 0.5f + 0.5f * sin(phase));
+        instance.scale = radii[i];
+        instance.rotation = 0.0f;
+        instance.color = packColorUnorm8(0.3f + 0.2f * i, 0.8f - 0.15f * i, 1.0f, 1.0f);
+    }
+}
 
-    for (int i = 0; i < triangles; i++) {
-        float angle1 = 3.14159f * 2.0f * i / triangles;
-        float angle2 = 3.14159f * 2.0f * (i + 1) / triangles;
+// вогнутая шестерня с отверстиями: контуры триангулируются заметанием
+// один раз и дальше берутся из кэша геометрии
+void addCircleContour(std::vector<Contour>& contours, int segments, float centerX, float centerY, float radius) {
+    const TrigTable& table = trigTable(segments);
+    Contour contour;
+    for (int i = 0; i < segments; i++) {
+        contour.push_back(centerX + radius * table.cosines[i]);
+        contour.push_back(centerY + radius * table.sines[i]);
+    }
+    contours.push_back(contour);
+}
 
-        // Центральная вершина 
-        vertices[i * 6] = centerX;
-        vertices[i * 6 + 1] = centerY;
+const CachedShape& getGearShape(GeometryCache& cache) {
+    const CachedShape* cached = findCachedShape(cache, "gear");
+    if (cached != nullptr) {
+        return *cached;
+    }
 
-        // Первая точка на окружности
-        vertices[i * 6 + 2] = centerX + radius * cos(angle1);
-        vertices[i * 6 + 3] = centerY + radius * sin(angle1);
+    // 12 зубцов, по 4 точки на вершине зубца и 4 во впадине
+    const int teeth = 12;
+    const int outline = teeth * 8;
+    const TrigTable& table = trigTable(outline);
+    std::vector<Contour> contours(1);
+    for (int i = 0; i < outline; i++) {
+        float radius = (i % 8) < 4 ? 0.8f : 0.62f;
+        contours[0].push_back(radius * table.cosines[i]);
+        contours[0].push_back(radius * table.sines[i]);
+    }
+    addCircleContour(contours, 32, 0.0f, 0.0f, 0.15f);
+    const TrigTable& windows = trigTable(6);
+    for (int i = 0; i < 6; i++) {
+        addCircleContour(contours, 16, 0.4f * windows.cosines[i], 0.4f * windows.sines[i], 0.1f);
+    }
 
-        // Вторая точка на окружности
-        vertices[i * 6 + 4] = centerX + radius * cos(angle2);
-        vertices[i * 6 + 5] = centerY + radius * sin(angle2);
+    IndexedMesh mesh;
+    if (!triangulatePolygon(contours, mesh)) {
+        std::cout << "Failed to triangulate gear outline" << std::endl;
     }
-    vertexCount = triangles * 3; 
-    return vertices;
+    const CachedShape& gear = cacheIndexedMesh(cache, "gear", mesh, (int)mesh.indices.size());
+    printVertexCacheReport("Gear", gear.vertexCache);
+    return gear;
 }
 
-// пятиугольник
-float* createPentagonVertices(int& vertexCount) {
-    static float vertices[5 * 3 * 2]; 
-    float centerX = 0.0f;
-    float centerY = 0.0f;
-    float radius = 0.5f;
-    int triangles = 5;
-
-    for (int i = 0; i < triangles; i++) {
-        float angle1 = 3.14159f * 2.0f * i / triangles;
-        float angle2 = 3.14159f * 2.0f * (i + 1) / triangles;
-
-        // Центральная 
-        vertices[i * 6] = centerX;
-        vertices[i * 6 + 1] = centerY;
+// самопересекающиеся гипотрохоиды, форма меняется каждый кадр; левая половина
+// заливается по правилу "не ноль", правая - "чет-нечет"
+const int STENCIL_GRID = 6;
+const int STENCIL_CURVE_POINTS = 240;
+
+void addStencilScene(StencilFiller& filler, float time) {
+    float cell = 2.0f / STENCIL_GRID;
+    std::vector<Contour> contours(1);
+    for (int y = 0; y < STENCIL_GRID; y++) {
+        for (int x = 0; x < STENCIL_GRID; x++) {
+            float centerX = -1.0f + (x + 0.5f) * cell;
+            float centerY = -1.0f + (y + 0.5f) * cell;
+            // R = 5, r = 3: кривая замыкается за три оборота
+            float d = 2.0f + 3.0f * (0.5f + 0.5f * sin(time + x * 0.7f + y * 0.4f));
+            float scale = cell * 0.45f / (2.0f + d);
+
+            Contour& contour = contours[0];
+            contour.clear();
+            for (int i = 0; i < STENCIL_CURVE_POINTS; i++) {
+                float t = 3.0f * 2.0f * 3.14159f * i / STENCIL_CURVE_POINTS;
+                contour.push_back(centerX + scale * (2.0f * cos(t) + d * cos(2.0f / 3.0f * t)));
+                contour.push_back(centerY + scale * (2.0f * sin(t) - d * sin(2.0f / 3.0f * t)));
+            }
+            FillRule rule = x < STENCIL_GRID / 2 ? FILL_NONZERO : FILL_EVEN_ODD;
+            addStencilPath(filler, contours, 0.3f + 0.12f * x, 0.9f - 0.12f * y, 0.6f, 1.0f, rule);
+        }
+    }
+}
 
-        // Первая точка
-        vertices[i * 6 + 2] = centerX + radius * cos(angle1);
-        vertices[i * 6 + 3] = centerY + radius * sin(angle1);
+// сетка сердечек из кубических кривых, которая приближается и удаляется;
+// пути строятся и разбиваются на отрезки заново в каждом кадре с допуском в пикселях
+const int HEART_GRID = 20;
+
+void buildHeartPath(VectorPath& path, float centerX, float centerY, float size) {
+    clearPath(path);
+    pathMoveTo(path, centerX, centerY - 0.4f * size);
+    pathCubicTo(path, centerX - 0.1f * size, centerY - 0.3f * size,
+        centerX - 0.5f * size, centerY - 0.05f * size, centerX - 0.5f * size, centerY + 0.2f * size);
+    pathCubicTo(path, centerX - 0.5f * size, centerY + 0.45f * size,
+        centerX - 0.2f * size, centerY + 0.55f * size, centerX, centerY + 0.3f * size);
+    pathCubicTo(path, centerX + 0.2f * size, centerY + 0.55f * size,
+        centerX + 0.5f * size, centerY + 0.45f * size, centerX + 0.5f * size, centerY + 0.2f * size);
+    pathCubicTo(path, centerX + 0.5f * size, centerY - 0.05f * size,
+        centerX + 0.1f * size, centerY - 0.3f * size, centerX, centerY - 0.4f * size);
+    pathClose(path);
+}
 
-        // Вторая точка
-        vertices[i * 6 + 4] = centerX + radius * cos(angle2);
-        vertices[i * 6 + 5] = centerY + radius * sin(angle2);
+void addHeartScene(StencilFiller& filler, VectorPath& path, std::vector<Contour>& contours,
+    float time, float pixelsPerUnit) {
+    float zoom = 1.0f + 15.0f * (0.5f - 0.5f * cos(time * 0.5f));
+    float cell = 2.0f / HEART_GRID * zoom;
+    for (int y = 0; y < HEART_GRID; y++) {
+        for (int x = 0; x < HEART_GRID; x++) {
+            float centerX = (-1.0f + (x + 0.5f) * 2.0f / HEART_GRID) * zoom;
+            float centerY = (-1.0f + (y + 0.5f) * 2.0f / HEART_GRID) * zoom;
+            // сердечки за краем экрана не строятся
+            if (fabs(centerX) - 0.5f * cell > 1.0f || fabs(centerY) - 0.5f * cell > 1.0f) {
+                continue;
+            }
+            buildHeartPath(path, centerX, centerY, cell * 0.9f);
+            flattenPath(path, 0.25f, pixelsPerUnit, contours);
+            addStencilPath(filler, contours, 0.9f, 0.2f + 0.03f * x, 0.3f + 0.03f * y, 1.0f, FILL_NONZERO);
+        }
     }
-    vertexCount = triangles * 3; 
-    return vertices;
 }
 
-void drawShape(float* vertices, int vertexCount) {
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+// контуры четырехугольника, веера и пятиугольника с заливкой и обводкой тремя
+// видами соединений, ниже - открытые ломаные с тремя видами торцов и штрихами
+void addOutlineScene(StencilFiller& filler, std::vector<Contour>& contours, float time, float pixelsPerUnit) {
+    const float shapeColors[3][3] = { { 0.2f, 0.4f, 0.8f }, { 0.8f, 0.5f, 0.2f }, { 0.3f, 0.7f, 0.4f } };
+    const LineJoin joins[3] = { JOIN_MITER, JOIN_ROUND, JOIN_BEVEL };
+    for (int i = 0; i < 3; i++) {
+        float centerX = -0.6f + 0.6f * i;
+        float centerY = 0.4f;
+        contours.clear();
+        if (i == 0) {
+            const float half = 0.2f;
+            const float square[8] = {
+                centerX - half, centerY - half, centerX + half, centerY - half,
+                centerX + half, centerY + half, centerX - half, centerY + half
+            };
+            contours.push_back(Contour(square, square + 8));
+        }
+        else {
+            addCircleContour(contours, i == 1 ? 8 : 5, centerX, centerY, 0.25f);
+        }
+        addStencilPath(filler, contours, shapeColors[i][0], shapeColors[i][1], shapeColors[i][2], 1.0f, FILL_NONZERO);
+
+        StrokeStyle style;
+        style.width = 0.04f;
+        style.join = joins[i];
+        // веер обведен бегущим пунктиром, который режется в шейдере
+        if (i == 1) {
+            style.dashCount = 2;
+            style.dashes[0] = 0.06f;
+            style.dashes[1] = 0.03f;
+            style.dashOffset = -time * 0.1f;
+        }
+        addStencilStroke(filler, contours, true, style, pixelsPerUnit, true);
+    }
+
+    const LineCap caps[3] = { CAP_BUTT, CAP_ROUND, CAP_SQUARE };
+    for (int i = 0; i < 3; i++) {
+        contours.assign(1, Contour());
+        Contour& zigzag = contours[0];
+        for (int k = 0; k < 6; k++) {
+            zigzag.push_back(-0.8f + 0.32f * k);
+            zigzag.push_back(-0.2f - 0.22f * i + (k % 2 ? 0.08f : -0.08f) * (1.0f + 0.5f * sin(time)));
+        }
+
+        StrokeStyle style;
+        style.width = 0.05f;
+        style.join = JOIN_ROUND;
+        style.cap = caps[i];
+        style.r = 0.9f;
+        style.g = 0.9f;
+        style.b = 0.3f + 0.3f * i;
+        // у скругленных штрихов шаблон из двух пар, он режется на CPU
+        if (caps[i] == CAP_ROUND) {
+            style.dashCount = 4;
+            style.dashes[0] = 0.12f;
+            style.dashes[1] = 0.08f;
+            style.dashes[2] = 0.0f;
+            style.dashes[3] = 0.08f;
+        }
+        addStencilStroke(filler, contours, false, style, pixelsPerUnit, false);
+    }
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * 2 * sizeof(float), vertices, GL_STATIC_DRAW);
+    // линия толщиной в один пиксель
+    contours.assign(1, Contour());
+    contours[0].push_back(-0.9f);
+    contours[0].push_back(-0.9f);
+    contours[0].push_back(0.9f);
+    contours[0].push_back(-0.8f);
+    StrokeStyle hairline;
+    hairline.width = 1.0f / pixelsPerUnit;
+    addStencilStroke(filler, contours, false, hairline, pixelsPerUnit, false);
+}
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// три фигуры в трех видах закрашивания: строки - фигуры, столбцы - виды.
+// Вершины каждой фигуры пишутся один раз, положение и поворот задает блок
+// DrawConstants. Вызовы добавляются по строкам, то есть вперемешку по программам
+struct ColoredVertex {
+    float x, y;
+    uint32_t color;  // unorm8 x 4
+};
+
+const int SHADING_SCENE_VERTICES = shapeTableVertexCount(QUAD_SHAPE)
+    + shapeTableVertexCount(FAN_SHAPE) + shapeTableVertexCount(PENTAGON_SHAPE);
+
+void writeShadingScene(ColoredVertex* vertices, int firstVertex, ShadedDrawQueue& queue,
+    ShaderPermutations& shading, float time) {
+    const float* tables[3] = { QUAD_SHAPE.vertices, FAN_SHAPE.vertices, PENTAGON_SHAPE.vertices };
+    const int counts[3] = {
+        shapeTableVertexCount(QUAD_SHAPE), shapeTableVertexCount(FAN_SHAPE), shapeTableVertexCount(PENTAGON_SHAPE)
+    };
+    const float cell = 2.0f / 3.0f;
+    const float scale = cell * 0.6f;
+    int written = 0;
+    for (int row = 0; row < 3; row++) {
+        int first = written;
+        for (int i = 0; i < counts[row]; i++) {
+            float x = tables[row][i * 2];
+            float y = tables[row][i * 2 + 1];
+            // цвет вершины по углу относительно центра, центр веера белый
+            uint32_t color = packColorUnorm8(1.0f, 1.0f, 1.0f, 1.0f);
+            if (x != 0.0f || y != 0.0f) {
+                float angle = atan2(y, x);
+                color = packColorUnorm8(0.5f + 0.5f * cos(angle), 0.5f + 0.5f * cos(angle + 2.094f),
+                    0.5f + 0.5f * cos(angle + 4.189f), 1.0f);
+            }
+            ColoredVertex& vertex = vertices[written++];
+            vertex.x = x;
+            vertex.y = y;
+            vertex.color = color;
+        }
+        for (int column = 0; column < SHADING_MODE_COUNT; column++) {
+            // цвет uniform меняется во времени, у остальных видов он не используется
+            DrawConstants constants;
+            constants.color[0] = 0.5f + 0.5f * sin(time + row);
+            constants.color[1] = 0.5f + 0.5f * sin(time * 1.3f + row);
+            constants.color[2] = 0.8f;
+            constants.color[3] = 1.0f;
+            constants.transform[0] = -1.0f + (column + 0.5f) * cell;
+            constants.transform[1] = 1.0f - (row + 0.5f) * cell;
+            constants.transform[2] = scale;
+            constants.transform[3] = time * 0.3f;
+            addShadedDraw(queue, shading, (ShadingMode)column, constants, firstVertex + first, counts[row]);
+        }
+    }
+}
 
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+// ошибка сжатых позиций в пикселях: меньше половины пикселя на глаз не отличить от float
+void printVertexFormatReport(const GeometryCache& cache, float pixelsPerUnit) {
+    const VertexFormat& format = cache.arena.format;
+    float errorPixels = cache.maxPositionError * pixelsPerUnit;
+    std::cout << "Vertex format: " << encodingName(format.attributes[0].encoding) << " positions, "
+        << format.stride << " bytes per vertex (float: " << 2 * sizeof(float) << "), max error "
+        << errorPixels << " px" << (errorPixels < 0.5f ? " (visually identical)" : " (VISIBLE)") << std::endl;
+}
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+// выход с ошибкой после initShaderPipeline: поток сборки нужно остановить до
+// glfwTerminate, иначе он переживает статические объекты конвейера
+int exitAfterError(ShaderWatcher& watcher) {
+    destroyShaderWatcher(watcher);
+    shutdownProgramCache();
+    shutdownShaderPipeline();
+    glfwTerminate();
+    return -1;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     if (!glfwInit()) {
         std::cout << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -158,6 +479,8 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // трафарет нужен для заливки "stencil, then cover"
+    glfwWindowHint(GLFW_STENCIL_BITS, 8);
 
     GLFWwindow* window = glfwCreateWindow(800, 600, "Three Shapes - Flat Shading", NULL, NULL);
     if (!window) {
@@ -170,12 +493,118 @@ int main() {
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK) {
         std::cout << "Failed to initialize GLEW" << std::endl;
+        glfwTerminate();
         return -1;
     }
 
-    unsigned int shaderProgram = createShaderProgram();
-    if (!shaderProgram) {
-        return -1;
+    // --bind-to-edit запрещает DSA даже там, где он поддерживается;
+    // --upload-auto выбирает способы загрузки замером при запуске;
+    // --no-program-cache собирает все шейдеры из исходников
+    bool benchmark = false;
+    bool allowDirectStateAccess = true;
+    bool measureUploads = false;
+    bool useProgramCache = true;
+    UploadConfig uploadConfig;
+    // --vertex-format=float|half|snorm16 - кодировка позиций в кэше геометрии
+    const std::string vertexFormatPrefix = "--vertex-format=";
+    AttributeEncoding positionEncoding = ENCODING_SNORM16;
+    // --shader-dir=<каталог> - откуда брать и где отслеживать исходники шейдеров
+    const std::string shaderDirectoryPrefix = "--shader-dir=";
+    std::string shaderDirectory = "shaders";
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--bench") {
+            benchmark = true;
+        }
+        else if (argument == "--bind-to-edit") {
+            allowDirectStateAccess = false;
+        }
+        else if (argument == "--upload-auto") {
+            measureUploads = true;
+        }
+        else if (argument == "--no-program-cache") {
+            useProgramCache = false;
+        }
+        else if (argument.compare(0, shaderDirectoryPrefix.size(), shaderDirectoryPrefix) == 0) {
+            shaderDirectory = argument.substr(shaderDirectoryPrefix.size());
+        }
+        else if (argument.compare(0, vertexFormatPrefix.size(), vertexFormatPrefix) == 0) {
+            AttributeEncoding encoding;
+            if (parseEncoding(argument.substr(vertexFormatPrefix.size()), encoding) && encoding != ENCODING_UNORM8) {
+                positionEncoding = encoding;
+            }
+            else {
+                std::cout << "Unknown vertex format: " << argument << std::endl;
+            }
+        }
+        else if (!parseUploadArgument(argument, uploadConfig)) {
+            std::cout << "Unknown argument: " << argument << std::endl;
+        }
+    }
+    resetGLState();
+    initShaderPipeline(window);
+    selectGpuBackend(allowDirectStateAccess);
+    std::cout << "GPU backend: " << gpuBackend().name() << std::endl;
+
+    if (benchmark) {
+        runBenchmarks();
+        shutdownShaderPipeline();
+        glfwTerminate();
+        return 0;
+    }
+
+    selectUploadMethods(uploadConfig, measureUploads);
+    std::cout << "Upload methods: dynamic " << uploadMethodName(uploadConfig.dynamicMethod)
+        << ", stream " << uploadMethodName(uploadConfig.streamMethod) << std::endl;
+
+    // двоичные программы прошлых запусков, до 16 МБ
+    if (useProgramCache && !initProgramCache("shader_cache", 16 * 1024 * 1024)) {
+        std::cout << "Program binary cache: not supported by the driver" << std::endl;
+    }
+    // программы собираются вне кадра, готовность проверяется между кадрами
+    std::cout << "Shader compile: " << shaderPipelineModeName() << std::endl;
+
+    // исходники из файлов, если они есть: правки собираются в фоне и
+    // подменяют программы без перезапуска
+    const std::string vertexShaderPath = shaderDirectory + "/shading.vert";
+    const std::string fragmentShaderPath = shaderDirectory + "/shading.frag";
+    std::string shadingVertexSource = vertexShaderSource;
+    std::string shadingFragmentSource = fragmentShaderSource;
+    ShaderWatcher shaderWatcher;
+    // последнее прочитанное содержимое файлов, с ним сравниваются изменения
+    std::string vertexFile;
+    std::string fragmentFile;
+    bool shaderFiles = loadShaderFile(vertexShaderPath, vertexFile) && loadShaderFile(fragmentShaderPath, fragmentFile);
+    if (shaderFiles) {
+        shadingVertexSource = vertexFile;
+        shadingFragmentSource = fragmentFile;
+        if (createShaderWatcher(shaderWatcher, shaderDirectory)) {
+            std::cout << "Shader hot reload: watching " << shaderDirectory << std::endl;
+        }
+    }
+    else {
+        std::cout << "Shaders: built-in sources (no " << vertexShaderPath << ")" << std::endl;
+    }
+
+    // основная программа - вариант с цветом-константой; после перезагрузки
+    // шейдеров имя программы меняется, поэтому оно берется из варианта каждый кадр
+    ShaderPermutations shading;
+    createShaderPermutations(shading, shadingVertexSource.c_str(), shadingFragmentSource.c_str());
+    int constantVariant = getShaderVariant(shading, shadingModeFeatures(SHADING_FLAT_CONSTANT));
+    // сборку основной программы нужно дождаться: с ошибкой в файлах работа идет
+    // на встроенных исходниках, а файлы по-прежнему отслеживаются
+    if (!waitShaderProgram(shading.variants[constantVariant].handle)) {
+        if (!shaderFiles) {
+            return exitAfterError(shaderWatcher);
+        }
+        std::cout << "Shaders: " << shaderDirectory << " sources failed to build, using built-in sources" << std::endl;
+        destroyShaderPermutations(shading);
+        shading = ShaderPermutations();
+        createShaderPermutations(shading, vertexShaderSource, fragmentShaderSource);
+        constantVariant = getShaderVariant(shading, shadingModeFeatures(SHADING_FLAT_CONSTANT));
+        if (!waitShaderProgram(shading.variants[constantVariant].handle)) {
+            return exitAfterError(shaderWatcher);
+        }
     }
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -183,48 +612,331 @@ int main() {
     int shapeType = 0; 
     float lastTime = glfwGetTime();
 
+    GeometryCache geometryCache;
+    createGeometryCache(geometryCache, positionEncoding);
+
+    // динамическая геометрия загружается стратегией класса BUFFER_DYNAMIC
+    UploadStrategy* vertexStream = createUploadStrategy(uploadMethodFor(uploadConfig, BUFFER_DYNAMIC));
+    vertexStream->create(GL_ARRAY_BUFFER, 64 * 1024);
+
+    unsigned int streamVAO = gpuBackend().createVertexArray();
+    gpuBackend().setVertexAttribute(streamVAO, 0, 0, 2, GL_FLOAT, false, 0);
+    gpuBackend().setVertexBuffer(streamVAO, 0, vertexStream->buffer(), 0, 2 * sizeof(float));
+
+    // вершины с цветом из того же буфера для сцены с тремя видами закрашивания
+    VertexFormat coloredFormat = positionFormat(ENCODING_FLOAT32);
+    addFormatAttribute(coloredFormat, 1, 4, ENCODING_UNORM8);
+    unsigned int coloredStreamVAO = gpuBackend().createVertexArray();
+    applyVertexFormat(coloredStreamVAO, 0, coloredFormat);
+    gpuBackend().setVertexBuffer(coloredStreamVAO, 0, vertexStream->buffer(), 0, coloredFormat.stride);
+    ShadedDrawQueue shadedDraws;
+
+    // константы кадра и вызовов, до 1 МБ за кадр
+    UniformRing uniformRing;
+    if (!createUniformRing(uniformRing, 1024 * 1024, uploadMethodFor(uploadConfig, BUFFER_STREAM))) {
+        return exitAfterError(shaderWatcher);
+    }
+
+    // экземпляры фигур: до 110000 за кадр
+    InstancedRenderer instancedRenderer;
+    if (!createInstancedRenderer(instancedRenderer, 110000, uploadMethodFor(uploadConfig, BUFFER_STREAM))) {
+        return exitAfterError(shaderWatcher);
+    }
+
+    // пакет команд для смешанной сцены
+    IndirectBatch indirectBatch;
+    createIndirectBatch(indirectBatch, MIXED_SCENE_SHAPES);
+    std::cout << "Mixed scene submission: "
+        << (indirectBatch.multiDrawIndirect ? "glMultiDraw*Indirect" : "glMultiDraw* fallback") << std::endl;
+
+    // многоугольники из gl_VertexID, без вершинных буферов
+    PolygonPuller polygonPuller;
+    if (!createPolygonPuller(polygonPuller, PULLED_GRID_SIZE * PULLED_GRID_SIZE)) {
+        return exitAfterError(shaderWatcher);
+    }
+
+    // заливка через трафарет для фигур, меняющихся каждый кадр
+    StencilFiller stencilFiller;
+    if (!createStencilFiller(stencilFiller, 2 * 1024 * 1024, uploadMethodFor(uploadConfig, BUFFER_DYNAMIC))) {
+        return exitAfterError(shaderWatcher);
+    }
+    // при первом запуске все программы собираются, при следующих берутся из кэша;
+    // статистика печатается, когда готова последняя программа
+    if (pendingShaderPrograms() == 0) {
+        printProgramCacheStats();
+    }
+
+    // индексированные сетки: сколько вершин и байт экономится на каждой фигуре
+    printIndexedSavings("Quad", getCachedShape(geometryCache, "quad", createQuadVertices).savings);
+    printIndexedSavings("Fan", getCachedShape(geometryCache, "fan", createFanVertices).savings);
+    printIndexedSavings("Pentagon", getCachedShape(geometryCache, "pentagon", createPentagonVertices).savings);
+    int startWidth, startHeight;
+    glfwGetFramebufferSize(window, &startWidth, &startHeight);
+    printVertexFormatReport(geometryCache, 0.5f * (startWidth > startHeight ? startWidth : startHeight));
+
     const char* shapeNames[] = {
         "QUADRILATERAL (2 triangles)",
         "FAN (8 triangles)",
-        "PENTAGON (5 triangles)"
+        "PENTAGON (5 triangles)",
+        "ANIMATED FAN (streamed)",
+        "INSTANCED FIELD (102400 polygons, 3 draw calls)",
+        "VERTEX PULLING (10000 mixed n-gons, 1 draw call)",
+        "MIXED SCENE (3000 shapes, multi-draw indirect)",
+        "ZOOMING CIRCLES (screen-space LOD)",
+        "CONCAVE GEAR WITH HOLES (sweep-line triangulation)",
+        "STENCIL FILL (36 animated self-intersecting paths)",
+        "VECTOR PATHS (400 Bezier hearts flattened per frame)",
+        "OUTLINES (joins, caps, dashes)",
+        "SHADING MODES (constant, uniform, gradient; sorted by program)"
     };
+    const int shapeCount = sizeof(shapeNames) / sizeof(shapeNames[0]);
 
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
+    VectorPath heartPath;
+    std::vector<Contour> heartContours;
+    std::vector<Contour> outlineContours;
+
+    LodSettings lodSettings;
+    LodState zoomLod[ZOOM_CIRCLES];
 
+    while (!glfwWindowShouldClose(window)) {
+        // размер окна проверяется каждый кадр, неизменный viewport отбрасывает кэш состояния
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        stateSetViewport(0, 0, framebufferWidth, framebufferHeight);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        beginCacheFrame(geometryCache);
+        vertexStream->beginFrame();
+        beginInstancedFrame(instancedRenderer);
+        beginPullerFrame(polygonPuller);
+        beginIndirectFrame(indirectBatch);
+        beginStencilFrame(stencilFiller);
+        beginUniformFrame(uniformRing);
+
+        bool shapeChanged = false;
         float currentTime = glfwGetTime();
+        FrameConstants frameConstants = {};
+        frameConstants.viewport[0] = (float)framebufferWidth;
+        frameConstants.viewport[1] = (float)framebufferHeight;
+        frameConstants.viewport[2] = framebufferWidth > 0 ? 1.0f / framebufferWidth : 0.0f;
+        frameConstants.viewport[3] = framebufferHeight > 0 ? 1.0f / framebufferHeight : 0.0f;
+        frameConstants.time = currentTime;
+        uploadUniformBlock(uniformRing, UNIFORM_FRAME_CONSTANTS, &frameConstants, sizeof(frameConstants));
         if (currentTime - lastTime > 3.0f) {
-            shapeType = (shapeType + 1) % 3;
+            shapeType = (shapeType + 1) % shapeCount;
+            shapeChanged = true;
             lastTime = currentTime;
             std::cout << "Current shape: " << shapeNames[shapeType] << std::endl;
         }
 
-        glUseProgram(shaderProgram);
-
-        int vertexCount;
-        float* vertices = nullptr; 
+        stateUseProgram(shading.variants[constantVariant].program);
+        bindGeometryCache(geometryCache);
 
         switch (shapeType) {
         case 0: 
-            vertices = createQuadVertices(vertexCount);
+            drawCachedShape(geometryCache, "quad", createQuadVertices);
             break;
         case 1: 
-            vertices = createFanVertices(vertexCount);
+            drawCachedShape(geometryCache, "fan", createFanVertices);
             break;
         case 2: 
-            vertices = createPentagonVertices(vertexCount);
+            drawCachedShape(geometryCache, "pentagon", createPentagonVertices);
+            break;
+        case 3: {
+            // first в glDrawArrays указывает на участок, выделенный в текущей области
+            const size_t stride = 2 * sizeof(float);
+            size_t offset;
+            float* vertices = (float*)vertexStream->allocate(ANIMATED_FAN_TRIANGLES * 3 * stride, stride, offset);
+            if (vertices != nullptr) {
+                int vertexCount = writeAnimatedFanVertices(vertices, currentTime);
+                vertexStream->commit();
+                stateBindVertexArray(streamVAO);
+                glDrawArrays(GL_TRIANGLES, (int)(offset / stride), vertexCount);
+            }
             break;
         }
-
-        if (vertices != nullptr) {
-            drawShape(vertices, vertexCount);
+        case 4: {
+            const char* names[] = { "quad", "fan", "pentagon" };
+            ShapeBuilder builders[] = { createQuadVertices, createFanVertices, createPentagonVertices };
+            for (int type = 0; type < 3; type++) {
+                size_t firstInstance;
+                PolygonInstance* instances = allocateInstances(instancedRenderer, instanceFieldCount(type), firstInstance);
+                if (instances == nullptr) {
+                    break;
+                }
+                int count = writeInstanceField(instances, type, currentTime);
+                const CachedShape& shape = getCachedShape(geometryCache, names[type], builders[type]);
+                drawInstances(instancedRenderer, geometryCache.arena, shape.range, firstInstance, count);
+            }
+            break;
         }
+        case 5: {
+            size_t firstRecord;
+            PolygonRecord* records = allocatePolygonRecords(polygonPuller, PULLED_GRID_SIZE * PULLED_GRID_SIZE, firstRecord);
+            if (records != nullptr) {
+                int count = writePolygonRecords(records, currentTime);
+                drawPulledPolygons(polygonPuller, firstRecord, count, PULLED_MAX_SIDES);
+            }
+            break;
+        }
+        case 6: {
+            const char* names[] = { "quad", "fan", "pentagon" };
+            ShapeBuilder builders[] = { createQuadVertices, createFanVertices, createPentagonVertices };
+            ArenaHandle meshes[3];
+            for (int type = 0; type < 3; type++) {
+                meshes[type] = getCachedShape(geometryCache, names[type], builders[type]).range;
+            }
+
+            size_t firstInstance;
+            PolygonInstance* instances = allocateInstances(instancedRenderer, MIXED_SCENE_SHAPES, firstInstance);
+            if (instances == nullptr) {
+                break;
+            }
+            static int shapeTypes[MIXED_SCENE_SHAPES];
+            writeMixedScene(instances, shapeTypes, currentTime);
+            for (int i = 0; i < MIXED_SCENE_SHAPES; i++) {
+                addIndirectDraw(indirectBatch, geometryCache.arena, meshes[shapeTypes[i]], 1, (unsigned int)(firstInstance + i));
+            }
+            submitIndirectBatch(indirectBatch, instancedRenderer, geometryCache.arena);
+            if (shapeChanged) {
+                std::cout << "Mixed scene: " << MIXED_SCENE_SHAPES << " shapes in "
+                    << indirectBatch.submitCalls << " draw calls" << std::endl;
+            }
+            break;
+        }
+        case 7: {
+            size_t firstInstance;
+            PolygonInstance* instances = allocateInstances(instancedRenderer, ZOOM_CIRCLES, firstInstance);
+            if (instances == nullptr) {
+                break;
+            }
+            float radii[ZOOM_CIRCLES];
+            writeZoomCircles(instances, radii, currentTime);
+            // радиус в NDC переводится в пиксели по большей стороне окна
+            float pixelsPerUnit = 0.5f * (framebufferWidth > framebufferHeight ? framebufferWidth : framebufferHeight);
+            for (int i = 0; i < ZOOM_CIRCLES; i++) {
+                int segments = selectCircleSegments(zoomLod[i], radii[i] * pixelsPerUnit, lodSettings);
+                const CachedShape& circle = getLodCircle(geometryCache, segments);
+                drawInstances(instancedRenderer, geometryCache.arena, circle.range, firstInstance + i, 1);
+            }
+            break;
+        }
+        case 8: {
+            const CachedShape& gear = getGearShape(geometryCache);
+            if (gear.range != INVALID_ARENA_HANDLE) {
+                drawArenaRange(geometryCache.arena, gear.range);
+            }
+            break;
+        }
+        case 9:
+            addStencilScene(stencilFiller, currentTime);
+            flushStencilFills(stencilFiller);
+            if (shapeChanged) {
+                std::cout << "Stencil fill: " << stencilFiller.paths.size() << " paths in "
+                    << stencilFiller.batches << " stencil/cover batches" << std::endl;
+            }
+            break;
+        case 10: {
+            float pixelsPerUnit = 0.5f * (framebufferWidth > framebufferHeight ? framebufferWidth : framebufferHeight);
+            addHeartScene(stencilFiller, heartPath, heartContours, currentTime, pixelsPerUnit);
+            flushStencilFills(stencilFiller);
+            break;
+        }
+        case 11: {
+            float pixelsPerUnit = 0.5f * (framebufferWidth > framebufferHeight ? framebufferWidth : framebufferHeight);
+            addOutlineScene(stencilFiller, outlineContours, currentTime, pixelsPerUnit);
+            flushStencilFills(stencilFiller);
+            if (shapeChanged) {
+                std::cout << "Outlines: " << stencilFiller.strokeVertices.size() << " stroke vertices, "
+                    << stencilFiller.batches << " batches with fills" << std::endl;
+            }
+            break;
+        }
+        case 12: {
+            const size_t stride = coloredFormat.stride;
+            size_t offset;
+            ColoredVertex* vertices = (ColoredVertex*)vertexStream->allocate(SHADING_SCENE_VERTICES * stride, stride, offset);
+            if (vertices == nullptr) {
+                break;
+            }
+            writeShadingScene(vertices, (int)(offset / stride), shadedDraws, shading, currentTime);
+            vertexStream->commit();
+            int draws = (int)shadedDraws.draws.size();
+            flushShadedDraws(shadedDraws, shading, uniformRing, coloredStreamVAO);
+            if (shapeChanged) {
+                std::cout << "Shading modes: " << draws << " draws, " << shadedDraws.programSwitches
+                    << " program switches (unsorted " << shadedDraws.unsortedProgramSwitches << "), "
+                    << shading.variants.size() << " variants for " << shading.lookups << " lookups; constants "
+                    << uniformRing.frameBytes << " bytes in " << uniformRing.frameUploads << " uploads" << std::endl;
+            }
+            break;
+        }
+        }
+        vertexStream->endFrame();
+        endInstancedFrame(instancedRenderer);
+        endPullerFrame(polygonPuller);
+        endIndirectFrame(indirectBatch);
+        endStencilFrame(stencilFiller);
+        endUniformFrame(uniformRing);
+
+        // в установившемся режиме кадр не должен ничего загружать
+        const GeometryCacheStats& stats = geometryCache.frame;
+        if (stats.misses > 0 || shapeChanged) {
+            std::cout << "Geometry cache: hits " << stats.hits
+                << ", misses " << stats.misses
+                << ", uploaded " << stats.bytesUploaded << " bytes this frame" << std::endl;
+        }
+        if (shapeChanged) {
+            const GLStateStats& stateStats = glStateStats();
+            std::cout << "GL state cache: " << stateStats.issued << " calls issued, "
+                << stateStats.skipped << " redundant calls skipped this frame" << std::endl;
+        }
+        resetGLStateStats();
 
         glfwSwapBuffers(window);
+        // измененные файлы шейдеров отправляются на сборку, до ее конца рисуют старые программы
+        if (pollShaderWatcher(shaderWatcher)) {
+            std::string vertexSource;
+            std::string fragmentSource;
+            if (loadShaderFile(vertexShaderPath, vertexSource) && loadShaderFile(fragmentShaderPath, fragmentSource)
+                && (vertexSource != vertexFile || fragmentSource != fragmentFile)) {
+                vertexFile = vertexSource;
+                fragmentFile = fragmentSource;
+                std::cout << "Shader reload: sources changed, rebuilding " << shading.variants.size() << " variants" << std::endl;
+                reloadShaderPermutations(shading, vertexSource, fragmentSource);
+            }
+        }
+        if (pendingShaderPrograms() > 0) {
+            pollShaderPrograms();
+            if (pendingShaderPrograms() == 0) {
+                printProgramCacheStats();
+            }
+        }
+        updateShaderPermutations(shading);
         glfwPollEvents();
     }
 
-    glDeleteProgram(shaderProgram);
+    std::cout << "Geometry cache total: hits " << geometryCache.total.hits
+        << ", misses " << geometryCache.total.misses
+        << ", uploaded " << geometryCache.total.bytesUploaded << " bytes" << std::endl;
+    int finalWidth, finalHeight;
+    glfwGetFramebufferSize(window, &finalWidth, &finalHeight);
+    printVertexFormatReport(geometryCache, 0.5f * (finalWidth > finalHeight ? finalWidth : finalHeight));
+
+    destroyUniformRing(uniformRing);
+    destroyStencilFiller(stencilFiller);
+    destroyIndirectBatch(indirectBatch);
+    destroyPolygonPuller(polygonPuller);
+    destroyInstancedRenderer(instancedRenderer);
+    gpuBackend().deleteVertexArray(streamVAO);
+    gpuBackend().deleteVertexArray(coloredStreamVAO);
+    vertexStream->destroy();
+    delete vertexStream;
+    destroyGeometryCache(geometryCache);
+    destroyShaderPermutations(shading);
+    destroyShaderWatcher(shaderWatcher);
+    shutdownProgramCache();
+    shutdownShaderPipeline();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
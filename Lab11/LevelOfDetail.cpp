@@ -0,0 +1,57 @@
+﻿#include "LevelOfDetail.h"
+#include <vector>
+
+#include "Tessellator.h"
+
+int lodBucketSegments(int segments, const LodSettings& settings) {
+    if (segments <= settings.minSegments) {
+        return settings.minSegments;
+    }
+    // корзины 2^k и 1.5 * 2^k
+    int bucket = 4;
+    while (bucket < segments) {
+        int middle = bucket + bucket / 2;
+        if (middle >= segments) {
+            bucket = middle;
+            break;
+        }
+        bucket *= 2;
+    }
+    return bucket < settings.maxSegments ? bucket : settings.maxSegments;
+}
+
+static int bucketForRadius(float pixelRadius, const LodSettings& settings) {
+    return lodBucketSegments(circleSegmentCount(pixelRadius, settings.maxChordError), settings);
+}
+
+int selectCircleSegments(LodState& state, float pixelRadius, const LodSettings& settings) {
+    int target = bucketForRadius(pixelRadius, settings);
+    if (state.segments == 0) {
+        state.segments = target;
+    }
+    else if (target > state.segments) {
+        // вверх, только если больше сегментов нужно даже на чуть меньшем радиусе
+        if (bucketForRadius(pixelRadius * (1.0f - settings.hysteresis), settings) > state.segments) {
+            state.segments = target;
+        }
+    }
+    else if (target < state.segments) {
+        // вниз, только если меньше сегментов хватает даже на чуть большем радиусе
+        if (bucketForRadius(pixelRadius * (1.0f + settings.hysteresis), settings) < state.segments) {
+            state.segments = target;
+        }
+    }
+    return state.segments;
+}
+
+const CachedShape& getLodCircle(GeometryCache& cache, int segments) {
+    std::string name = "circle/" + std::to_string(segments);
+    const CachedShape* cached = findCachedShape(cache, name);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    std::vector<float> vertices(polygonVertexCount(segments) * 2);
+    int vertexCount = writeCircle(vertices.data(), segments, 0.0f, 0.0f, 1.0f);
+    return cacheShapeVertices(cache, name, vertices.data(), vertexCount);
+}
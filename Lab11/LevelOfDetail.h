@@ -0,0 +1,28 @@
+﻿#pragma once
+#include "GeometryCache.h"
+
+// экранная детализация кругов и вееров: число сегментов выбирается по радиусу
+// на экране в пикселях и допустимому прогибу хорды, а сетки кэшируются по корзинам
+
+struct LodSettings {
+    float maxChordError = 0.5f;  // допустимое отклонение хорды от окружности, пикселей
+    float hysteresis = 0.2f;     // на какую долю радиус должен уйти за порог корзины
+    int minSegments = 6;
+    int maxSegments = 512;
+};
+
+// выбранная детализация одной фигуры между кадрами
+struct LodState {
+    int segments = 0;  // 0 - еще не выбиралась
+};
+
+// округляет число сегментов вверх до корзины: 6, 8, 12, 16, 24, 32, ...
+// (степени двойки и полуторные промежуточные), чтобы в кэше было мало сеток
+int lodBucketSegments(int segments, const LodSettings& settings);
+
+// корзина для радиуса pixelRadius с гистерезисом: при небольших колебаниях
+// радиуса около порога детализация не прыгает туда-обратно
+int selectCircleSegments(LodState& state, float pixelRadius, const LodSettings& settings);
+
+// единичный круг из segments сегментов; в кэше лежит под именем "circle/<segments>"
+const CachedShape& getLodCircle(GeometryCache& cache, int segments);
@@ -0,0 +1,148 @@
+﻿#include "MeshOptimizer.h"
+#include <iostream>
+#include <vector>
+
+VertexCacheStats analyzeVertexCache(const IndexedMesh& mesh, int cacheSize) {
+    VertexCacheStats stats;
+    int vertexCount = meshVertexCount(mesh);
+    size_t triangles = mesh.indices.size() / 3;
+    if (triangles == 0 || vertexCount == 0) {
+        return stats;
+    }
+
+    // вершина в FIFO-кэше, если с момента ее загрузки было меньше cacheSize промахов
+    std::vector<long long> loadedAt(vertexCount, -(long long)cacheSize - 1);
+    long long misses = 0;
+    for (uint32_t index : mesh.indices) {
+        if (misses - loadedAt[index] > cacheSize) {
+            loadedAt[index] = misses;
+            misses++;
+        }
+    }
+    stats.acmr = (float)misses / triangles;
+    stats.atvr = (float)misses / vertexCount;
+    return stats;
+}
+
+void optimizeVertexCache(IndexedMesh& mesh, int cacheSize) {
+    int vertexCount = meshVertexCount(mesh);
+    int triangleCount = (int)(mesh.indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // смежность вершина -> треугольники в сжатом виде (CSR)
+    std::vector<int> live(vertexCount, 0);
+    for (uint32_t index : mesh.indices) {
+        live[index]++;
+    }
+    std::vector<int> adjacencyStart(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; v++) {
+        adjacencyStart[v + 1] = adjacencyStart[v] + live[v];
+    }
+    std::vector<int> adjacency(mesh.indices.size());
+    std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (int t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[mesh.indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(mesh.indices.size());
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<int> deadEnd;       // недавно выданные вершины, к ним возвращаемся в тупике
+    std::vector<int> candidates;
+    int time = cacheSize + 1;
+    int cursor = 0;                 // следующая вершина по порядку, если стек тупиков пуст
+
+    int fanning = 0;
+    while (fanning >= 0) {
+        // веер из всех еще не выданных треугольников вокруг текущей вершины
+        candidates.clear();
+        for (int a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++) {
+            int t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                int v = (int)mesh.indices[t * 3 + k];
+                output.push_back((uint32_t)v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time;
+                    time++;
+                }
+            }
+        }
+
+        // следующая - вершина веера, которая еще останется в кэше после своего веера
+        // и дольше всех в нем пробыла
+        int next = -1;
+        int best = -1;
+        for (int v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+        if (next < 0) {
+            while (!deadEnd.empty() && next < 0) {
+                int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    next = v;
+                }
+            }
+            while (next < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0) {
+                    next = cursor;
+                }
+                cursor++;
+            }
+        }
+        fanning = next;
+    }
+    mesh.indices.swap(output);
+}
+
+void optimizeVertexFetch(IndexedMesh& mesh) {
+    int vertexCount = meshVertexCount(mesh);
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    std::vector<float> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = (uint32_t)(vertices.size() / 2);
+            vertices.push_back(mesh.vertices[index * 2]);
+            vertices.push_back(mesh.vertices[index * 2 + 1]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+VertexCacheReport optimizeMesh(IndexedMesh& mesh) {
+    VertexCacheReport report;
+    report.before = analyzeVertexCache(mesh);
+    optimizeVertexCache(mesh);
+    optimizeVertexFetch(mesh);
+    report.after = analyzeVertexCache(mesh);
+    return report;
+}
+
+void printVertexCacheReport(const char* name, const VertexCacheReport& report) {
+    std::cout << name << ": ACMR " << report.before.acmr << " -> " << report.after.acmr
+        << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include "IndexedMesh.h"
+
+// переупорядочение индексированных сеток под кэш вершин после преобразования
+// (Tipsify: Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex
+// Locality and Reduced Overdraw", 2007) и под порядок выборки вершин.
+// Оба прохода линейны по числу треугольников.
+
+// размер FIFO-кэша вершин, под который идет оптимизация и замер
+const int VERTEX_CACHE_SIZE = 16;
+
+// ACMR - промахов кэша на треугольник (лучшее ~0.5 для регулярной сетки),
+// ATVR - промахов на вершину (лучшее 1.0)
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+struct VertexCacheReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// моделирует FIFO-кэш из cacheSize вершин на порядке индексов сетки
+VertexCacheStats analyzeVertexCache(const IndexedMesh& mesh, int cacheSize = VERTEX_CACHE_SIZE);
+
+// меняет порядок треугольников (вершины и обход каждого треугольника сохраняются)
+void optimizeVertexCache(IndexedMesh& mesh, int cacheSize = VERTEX_CACHE_SIZE);
+
+// нумерует вершины в порядке первого использования, неиспользуемые удаляются
+void optimizeVertexFetch(IndexedMesh& mesh);
+
+// оба прохода подряд; возвращает замеры до и после
+VertexCacheReport optimizeMesh(IndexedMesh& mesh);
+
+void printVertexCacheReport(const char* name, const VertexCacheReport& report);
@@ -0,0 +1,97 @@
+﻿#include "PolygonPuller.h"
+#include <GL/glew.h>
+
+#include "GLState.h"
+#include "GpuBackend.h"
+#include "Shader.h"
+#include "UniformBuffers.h"
+
+static const char* pullingVertexShaderSource = R"(
+    #version 330 core
+    uniform samplerBuffer uRecords;
+    uniform int uFirstRecord;
+    out vec4 vColor;
+    void main() {
+        int record = (uFirstRecord + gl_InstanceID) * 2;
+        vec4 geometry = texelFetch(uRecords, record);      // центр, радиус, поворот
+        vec4 colorSides = texelFetch(uRecords, record + 1);
+        int sides = int(colorSides.a);
+
+        int triangle = gl_VertexID / 3;
+        int corner = gl_VertexID % 3;
+        vec2 position = geometry.xy;
+        // угол 0 - центр; лишние треугольники остаются в центре и не растеризуются
+        if (triangle < sides && corner != 0) {
+            float angle = geometry.w + 6.2831853 * float(triangle + corner - 1) / float(sides);
+            position += geometry.z * vec2(cos(angle), sin(angle));
+        }
+        gl_Position = vec4(position, 0.0, 1.0);
+        vColor = vec4(colorSides.rgb, 1.0);
+    }
+)";
+
+static const char* pullingFragmentShaderSource = R"(
+    #version 330 core
+    in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+bool createPolygonPuller(PolygonPuller& puller, size_t maxShapesPerFrame) {
+    puller.program = createShaderProgram(pullingVertexShaderSource, pullingFragmentShaderSource);
+    if (!puller.program) {
+        return false;
+    }
+    puller.firstRecordLocation = uniformLocation(puller.program, "uFirstRecord");
+    stateUseProgram(puller.program);
+    glUniform1i(uniformLocation(puller.program, "uRecords"), 0);
+    stateUseProgram(0);
+
+    createStreamBuffer(puller.records, GL_TEXTURE_BUFFER, maxShapesPerFrame * sizeof(PolygonRecord));
+
+    // текстура видит весь буфер, нужная область выбирается через uFirstRecord
+    GpuBackend& backend = gpuBackend();
+    puller.texture = backend.createTextureBuffer(puller.records.buffer, GL_RGBA32F);
+    puller.VAO = backend.createVertexArray();
+    return true;
+}
+
+void destroyPolygonPuller(PolygonPuller& puller) {
+    gpuBackend().deleteVertexArray(puller.VAO);
+    stateForgetTexture(puller.texture);
+    glDeleteTextures(1, &puller.texture);
+    destroyStreamBuffer(puller.records);
+    stateForgetProgram(puller.program);
+    deleteShaderProgram(puller.program);
+    puller.VAO = 0;
+    puller.texture = 0;
+    puller.program = 0;
+}
+
+void beginPullerFrame(PolygonPuller& puller) {
+    beginStreamFrame(puller.records);
+    puller.drawCalls = 0;
+}
+
+void endPullerFrame(PolygonPuller& puller) {
+    endStreamFrame(puller.records);
+}
+
+PolygonRecord* allocatePolygonRecords(PolygonPuller& puller, int count, size_t& firstRecord) {
+    size_t offset;
+    void* memory = streamAllocate(puller.records, count * sizeof(PolygonRecord), sizeof(PolygonRecord), offset);
+    firstRecord = offset / sizeof(PolygonRecord);
+    return (PolygonRecord*)memory;
+}
+
+void drawPulledPolygons(PolygonPuller& puller, size_t firstRecord, int count, int maxSides) {
+    streamCommit(puller.records);
+    stateUseProgram(puller.program);
+    glUniform1i(puller.firstRecordLocation, (GLint)firstRecord);
+    stateBindTexture(0, GL_TEXTURE_BUFFER, puller.texture);
+    stateBindVertexArray(puller.VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, maxSides * 3, count);
+    puller.drawCalls++;
+}
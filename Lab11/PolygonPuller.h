@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <cstddef>
+
+#include "StreamBuffer.h"
+
+// описание правильного многоугольника для выборки вершин в шейдере (32 байта = 2 текселя RGBA32F)
+struct PolygonRecord {
+    float centerX, centerY;
+    float radius;
+    float rotation;
+    float r, g, b;
+    float sides;  // число сторон, хранится как float, чтобы запись была одним типом текселей
+};
+
+// режим без вершинных буферов: вершинный шейдер вычисляет точки обода
+// из gl_VertexID и gl_InstanceID по записям из текстурного буфера.
+// Один экземпляр = одна фигура; многоугольники с разным числом сторон
+// рисуются одним вызовом, лишние треугольники вырождаются в центр.
+struct PolygonPuller {
+    unsigned int program = 0;
+    unsigned int VAO = 0;      // пустой, нужен только core-профилю
+    unsigned int texture = 0;  // GL_TEXTURE_BUFFER поверх потокового буфера
+    int firstRecordLocation = -1;
+    StreamBuffer records;
+    int drawCalls = 0;
+};
+
+bool createPolygonPuller(PolygonPuller& puller, size_t maxShapesPerFrame);
+void destroyPolygonPuller(PolygonPuller& puller);
+
+void beginPullerFrame(PolygonPuller& puller);
+void endPullerFrame(PolygonPuller& puller);
+
+PolygonRecord* allocatePolygonRecords(PolygonPuller& puller, int count, size_t& firstRecord);
+
+// maxSides - наибольшее число сторон среди фигур вызова
+void drawPulledPolygons(PolygonPuller& puller, size_t firstRecord, int count, int maxSides);
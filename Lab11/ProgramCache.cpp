@@ -0,0 +1,281 @@
+﻿#include "ProgramCache.h"
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// заголовок файла записи
+struct ProgramBinaryHeader {
+    char magic[4];
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+static const char PROGRAM_BINARY_MAGIC[4] = { 'L', '1', '1', 'P' };
+
+struct ProgramCacheEntry {
+    uint64_t key = 0;
+    size_t bytes = 0;
+    uint64_t lastUse = 0;  // момент последнего обращения по счетчику useClock
+};
+
+struct ProgramCacheState {
+    bool enabled = false;
+    bool indexChanged = false;
+    std::string directory;
+    size_t maxBytes = 0;
+    std::string driver;  // GL_VENDOR, GL_RENDERER и GL_VERSION
+    std::vector<ProgramCacheEntry> entries;
+    uint64_t useClock = 0;
+    ProgramCacheStats stats;
+};
+
+static ProgramCacheState cache;
+
+static uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string entryPath(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return cache.directory + "/" + name;
+}
+
+static std::string indexPath() {
+    return cache.directory + "/index.txt";
+}
+
+static void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// индекс: по строке "ключ размер последнее_обращение" на запись
+static void loadIndex() {
+    cache.entries.clear();
+    std::ifstream file(indexPath());
+    ProgramCacheEntry entry;
+    while (file >> std::hex >> entry.key >> std::dec >> entry.bytes >> entry.lastUse) {
+        cache.entries.push_back(entry);
+        cache.useClock = entry.lastUse > cache.useClock ? entry.lastUse : cache.useClock;
+    }
+}
+
+static void saveIndex() {
+    std::ofstream file(indexPath(), std::ios::trunc);
+    for (const ProgramCacheEntry& entry : cache.entries) {
+        file << std::hex << entry.key << std::dec << " " << entry.bytes << " " << entry.lastUse << "\n";
+    }
+    cache.indexChanged = false;
+}
+
+static ProgramCacheEntry* findEntry(uint64_t key) {
+    for (ProgramCacheEntry& entry : cache.entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// убирает запись из индекса; файл удаляется только при deleteFile
+static void forgetEntry(uint64_t key, bool deleteFile) {
+    for (size_t i = 0; i < cache.entries.size(); i++) {
+        if (cache.entries[i].key == key) {
+            if (deleteFile) {
+                std::remove(entryPath(key).c_str());
+            }
+            cache.entries.erase(cache.entries.begin() + i);
+            cache.indexChanged = true;
+            return;
+        }
+    }
+}
+
+// удаляет самые давние записи, пока кэш не уложится в maxBytes
+static void enforceSizeLimit() {
+    size_t total = 0;
+    for (const ProgramCacheEntry& entry : cache.entries) {
+        total += entry.bytes;
+    }
+    while (total > cache.maxBytes && !cache.entries.empty()) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < cache.entries.size(); i++) {
+            if (cache.entries[i].lastUse < cache.entries[oldest].lastUse) {
+                oldest = i;
+            }
+        }
+        total -= cache.entries[oldest].bytes;
+        forgetEntry(cache.entries[oldest].key, true);
+        cache.stats.evicted++;
+    }
+}
+
+bool initProgramCache(const std::string& directory, size_t maxBytes) {
+    cache = ProgramCacheState();
+    int formats = 0;
+    if (GLEW_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    if (formats == 0) {
+        return false;
+    }
+
+    const char* strings[3] = {
+        (const char*)glGetString(GL_VENDOR),
+        (const char*)glGetString(GL_RENDERER),
+        (const char*)glGetString(GL_VERSION)
+    };
+    for (const char* string : strings) {
+        cache.driver += string != nullptr ? string : "";
+        cache.driver += '\n';
+    }
+    cache.directory = directory;
+    cache.maxBytes = maxBytes;
+    makeDirectory(directory);
+    loadIndex();
+    cache.enabled = true;
+    return true;
+}
+
+void shutdownProgramCache() {
+    if (cache.enabled && cache.indexChanged) {
+        saveIndex();
+    }
+    cache.enabled = false;
+}
+
+bool programCacheEnabled() {
+    return cache.enabled;
+}
+
+uint64_t programCacheKey(const char* vertexShaderSource, const char* fragmentShaderSource) {
+    // нулевой байт между частями, чтобы "ab" + "c" и "a" + "bc" различались
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, vertexShaderSource, strlen(vertexShaderSource) + 1);
+    hash = fnv1a(hash, fragmentShaderSource, strlen(fragmentShaderSource) + 1);
+    return fnv1a(hash, cache.driver.data(), cache.driver.size());
+}
+
+unsigned int loadCachedProgram(uint64_t key) {
+    ProgramCacheEntry* entry = cache.enabled ? findEntry(key) : nullptr;
+    if (entry == nullptr) {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(entryPath(key), std::ios::binary);
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    bool valid = (bool)file.read((char*)&header, sizeof(header))
+        && memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) == 0 && header.key == key;
+    if (valid) {
+        binary.resize(header.length);
+        valid = (bool)file.read(binary.data(), header.length);
+    }
+
+    unsigned int program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (program == 0) {
+        // файл испорчен или драйвер не принимает свой прежний формат - соберем заново
+        cache.stats.rejected++;
+        forgetEntry(key, true);
+        return 0;
+    }
+
+    entry->lastUse = ++cache.useClock;
+    cache.indexChanged = true;
+    cache.stats.loaded++;
+    cache.stats.loadMilliseconds += millisecondsSince(start);
+    return program;
+}
+
+void storeCachedProgram(uint64_t key, unsigned int program) {
+    if (!cache.enabled) {
+        return;
+    }
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+    header.key = key;
+    header.reserved = 0;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    header.format = format;
+    header.length = (uint32_t)length;
+
+    std::ofstream file(entryPath(key), std::ios::binary | std::ios::trunc);
+    if (!file.write((const char*)&header, sizeof(header)) || !file.write(binary.data(), length)) {
+        std::cout << "Failed to write program cache entry " << entryPath(key) << std::endl;
+        return;
+    }
+    file.close();
+
+    forgetEntry(key, false);
+    ProgramCacheEntry entry;
+    entry.key = key;
+    entry.bytes = sizeof(header) + length;
+    entry.lastUse = ++cache.useClock;
+    cache.entries.push_back(entry);
+    enforceSizeLimit();
+    saveIndex();
+}
+
+void recordProgramCompile() {
+    cache.stats.compiled++;
+}
+
+void recordProgramCompileTime(double milliseconds) {
+    cache.stats.compileMilliseconds += milliseconds;
+}
+
+const ProgramCacheStats& programCacheStats() {
+    return cache.stats;
+}
+
+void printProgramCacheStats() {
+    const ProgramCacheStats& stats = cache.stats;
+    std::cout << "Shader programs: " << stats.loaded << " from cache in " << stats.loadMilliseconds << " ms, "
+        << stats.compiled << " compiled in " << stats.compileMilliseconds << " ms";
+    if (stats.rejected > 0 || stats.evicted > 0) {
+        std::cout << " (" << stats.rejected << " rejected, " << stats.evicted << " evicted)";
+    }
+    std::cout << (cache.enabled ? "" : ", program cache off") << std::endl;
+}
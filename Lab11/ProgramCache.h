@@ -0,0 +1,40 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// дисковый кэш двоичных программ (glGetProgramBinary / glProgramBinary).
+// Ключ - FNV-1a от исходников шейдеров и строк GL_VENDOR, GL_RENDERER,
+// GL_VERSION, так что обновление драйвера само делает старые записи ненужными.
+// Размер ограничен: при переполнении удаляются давно не использованные записи.
+// createShaderProgram пользуется кэшем автоматически после initProgramCache.
+
+struct ProgramCacheStats {
+    int loaded = 0;     // программ взято из кэша
+    int compiled = 0;   // программ собрано из исходников
+    int rejected = 0;   // двоичных программ, которые драйвер не принял
+    int evicted = 0;    // записей удалено из-за ограничения размера
+    double loadMilliseconds = 0.0;
+    // время, пока хотя бы одна программа собиралась: от отправки до готовности,
+    // включая работу потоков драйвера и потока сборки
+    double compileMilliseconds = 0.0;
+};
+
+// нужен готовый контекст GL; false, если драйвер не умеет отдавать двоичные программы
+bool initProgramCache(const std::string& directory, size_t maxBytes);
+// сохраняет порядок использования записей на диск
+void shutdownProgramCache();
+bool programCacheEnabled();
+
+uint64_t programCacheKey(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+// программа из кэша или 0, если записи нет или драйвер ее отверг (запись удаляется)
+unsigned int loadCachedProgram(uint64_t key);
+// сохраняет собранную программу; перед сборкой у нее должен быть
+// выставлен GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+void storeCachedProgram(uint64_t key, unsigned int program);
+
+void recordProgramCompile();
+void recordProgramCompileTime(double milliseconds);
+const ProgramCacheStats& programCacheStats();
+void printProgramCacheStats();
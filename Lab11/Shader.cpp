@@ -0,0 +1,30 @@
+﻿#include "Shader.h"
+#include <GL/glew.h>
+#include <iostream>
+
+#include "ShaderPipeline.h"
+
+unsigned int compileShader(unsigned int type, const char* source) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "Shader compilation error:\n" << infoLog << std::endl;
+        return 0;
+    }
+    return shader;
+}
+
+unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+    return shaderProgramObject(submitShaderProgram(vertexShaderSource, fragmentShaderSource));
+}
+
+void deleteShaderProgram(unsigned int program) {
+    forgetShaderProgram(program);
+    glDeleteProgram(program);
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+
+// компилирует шейдер, при ошибке печатает лог и возвращает 0
+unsigned int compileShader(unsigned int type, const char* source);
+
+// отправляет программу на сборку (ShaderPipeline.h) и сразу возвращает ее имя;
+// статус проверяется позже, ошибки печатаются при завершении сборки. Если
+// включен дисковый кэш (ProgramCache.h), программа сначала ищется там
+unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+// удаляет программу, созданную createShaderProgram, даже если сборка не закончена
+void deleteShaderProgram(unsigned int program);
@@ -0,0 +1,228 @@
+﻿#include "ShaderPermutations.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GLState.h"
+#include "Shader.h"
+
+struct FeatureDefine {
+    unsigned int feature;
+    const char* name;
+    unsigned int supersededBy;  // если есть эти признаки, этот ничего не меняет
+};
+
+static const FeatureDefine featureDefines[] = {
+    { SHADING_UNIFORM_COLOR, "UNIFORM_COLOR", SHADING_VERTEX_COLOR },
+    { SHADING_VERTEX_COLOR, "VERTEX_COLOR", 0 },
+    { SHADING_DRAW_TRANSFORM, "DRAW_TRANSFORM", 0 }
+};
+static const int featureDefineCount = sizeof(featureDefines) / sizeof(featureDefines[0]);
+
+unsigned int shadingModeFeatures(ShadingMode mode) {
+    switch (mode) {
+    case SHADING_FLAT_UNIFORM:
+        return SHADING_UNIFORM_COLOR;
+    case SHADING_GRADIENT:
+        return SHADING_VERTEX_COLOR;
+    default:
+        return 0;
+    }
+}
+
+const char* shadingModeName(ShadingMode mode) {
+    switch (mode) {
+    case SHADING_FLAT_UNIFORM:
+        return "flat uniform";
+    case SHADING_GRADIENT:
+        return "gradient";
+    default:
+        return "flat constant";
+    }
+}
+
+void createShaderPermutations(ShaderPermutations& permutations, const char* vertexSource, const char* fragmentSource) {
+    permutations.vertexSource = vertexSource;
+    permutations.fragmentSource = fragmentSource;
+    permutations.usedFeatures = 0;
+    for (int i = 0; i < featureDefineCount; i++) {
+        const char* name = featureDefines[i].name;
+        if (permutations.vertexSource.find(name) != std::string::npos
+            || permutations.fragmentSource.find(name) != std::string::npos) {
+            permutations.usedFeatures |= featureDefines[i].feature;
+        }
+    }
+}
+
+void destroyShaderPermutations(ShaderPermutations& permutations) {
+    for (ShaderVariant& variant : permutations.variants) {
+        stateForgetProgram(variant.program);
+        deleteShaderProgram(variant.program);
+        if (variant.pendingHandle != INVALID_PROGRAM_HANDLE) {
+            deleteShaderProgram(shaderProgramObject(variant.pendingHandle));
+        }
+    }
+    permutations.variants.clear();
+    permutations.variantIndex.clear();
+}
+
+unsigned int canonicalShaderFeatures(const ShaderPermutations& permutations, unsigned int features) {
+    unsigned int canonical = features & permutations.usedFeatures;
+    for (int i = 0; i < featureDefineCount; i++) {
+        if (canonical & featureDefines[i].supersededBy) {
+            canonical &= ~featureDefines[i].feature;
+        }
+    }
+    return canonical;
+}
+
+// defines вставляются после строки #version, которая должна идти первой
+static std::string addDefines(const std::string& source, unsigned int features) {
+    std::string defines;
+    for (int i = 0; i < featureDefineCount; i++) {
+        if (features & featureDefines[i].feature) {
+            defines += std::string("#define ") + featureDefines[i].name + "\n";
+        }
+    }
+    size_t version = source.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return defines + source;
+    }
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+int getShaderVariant(ShaderPermutations& permutations, unsigned int features) {
+    permutations.lookups++;
+    unsigned int canonical = canonicalShaderFeatures(permutations, features);
+    auto found = permutations.variantIndex.find(canonical);
+    if (found != permutations.variantIndex.end()) {
+        return found->second;
+    }
+    ShaderVariant variant;
+    variant.features = canonical;
+    std::string vertexSource = addDefines(permutations.vertexSource, canonical);
+    std::string fragmentSource = addDefines(permutations.fragmentSource, canonical);
+    variant.handle = submitShaderProgram(vertexSource.c_str(), fragmentSource.c_str());
+    variant.program = shaderProgramObject(variant.handle);
+    int index = (int)permutations.variants.size();
+    permutations.variants.push_back(variant);
+    permutations.variantIndex[canonical] = index;
+    return index;
+}
+
+unsigned int shaderVariantProgram(ShaderPermutations& permutations, unsigned int features) {
+    return permutations.variants[getShaderVariant(permutations, features)].program;
+}
+
+void reloadShaderPermutations(ShaderPermutations& permutations, const std::string& vertexSource,
+    const std::string& fragmentSource) {
+    permutations.vertexSource = vertexSource;
+    permutations.fragmentSource = fragmentSource;
+    for (ShaderVariant& variant : permutations.variants) {
+        // незаконченная сборка прошлой правки больше не нужна
+        if (variant.pendingHandle != INVALID_PROGRAM_HANDLE) {
+            deleteShaderProgram(shaderProgramObject(variant.pendingHandle));
+        }
+        std::string variantVertexSource = addDefines(vertexSource, variant.features);
+        std::string variantFragmentSource = addDefines(fragmentSource, variant.features);
+        variant.pendingHandle = submitShaderProgram(variantVertexSource.c_str(), variantFragmentSource.c_str());
+    }
+}
+
+int updateShaderPermutations(ShaderPermutations& permutations) {
+    int swapped = 0;
+    int failed = 0;
+    for (ShaderVariant& variant : permutations.variants) {
+        if (variant.pendingHandle == INVALID_PROGRAM_HANDLE || !isShaderProgramReady(variant.pendingHandle)) {
+            continue;
+        }
+        // сборка закончена, ожидания здесь уже нет
+        unsigned int program = shaderProgramObject(variant.pendingHandle);
+        if (waitShaderProgram(variant.pendingHandle)) {
+            stateForgetProgram(variant.program);
+            deleteShaderProgram(variant.program);
+            variant.handle = variant.pendingHandle;
+            variant.program = program;
+            variant.ready = true;
+            variant.failed = false;
+            swapped++;
+        }
+        else {
+            deleteShaderProgram(program);
+            failed++;
+        }
+        variant.pendingHandle = INVALID_PROGRAM_HANDLE;
+    }
+    if (failed > 0) {
+        std::cout << "Shader reload: " << failed << " variants failed, previous programs kept" << std::endl;
+    }
+    if (swapped > 0) {
+        std::cout << "Shader reload: " << swapped << " variants swapped" << std::endl;
+    }
+    return swapped;
+}
+
+void addShadedDraw(ShadedDrawQueue& queue, ShaderPermutations& permutations, ShadingMode mode,
+    const DrawConstants& constants, int first, int count) {
+    ShadedDraw draw;
+    draw.variant = getShaderVariant(permutations, shadingModeFeatures(mode) | SHADING_DRAW_TRANSFORM);
+    draw.constants = constants;
+    draw.first = first;
+    draw.count = count;
+    queue.draws.push_back(draw);
+}
+
+static int countProgramSwitches(const std::vector<ShadedDraw>& draws) {
+    int switches = 0;
+    for (size_t i = 0; i < draws.size(); i++) {
+        if (i == 0 || draws[i].variant != draws[i - 1].variant) {
+            switches++;
+        }
+    }
+    return switches;
+}
+
+void flushShadedDraws(ShadedDrawQueue& queue, ShaderPermutations& permutations, UniformRing& uniforms, unsigned int vao) {
+    if (queue.draws.empty()) {
+        return;
+    }
+    queue.unsortedProgramSwitches = countProgramSwitches(queue.draws);
+    // устойчивая сортировка сохраняет порядок наложения внутри варианта
+    std::stable_sort(queue.draws.begin(), queue.draws.end(),
+        [](const ShadedDraw& a, const ShadedDraw& b) { return a.variant < b.variant; });
+    queue.programSwitches = countProgramSwitches(queue.draws);
+
+    // константы в порядке рисования, одна загрузка на всю очередь
+    int count = (int)queue.draws.size();
+    size_t firstOffset;
+    size_t stride;
+    unsigned char* blocks = (unsigned char*)allocateUniformBlocks(uniforms, sizeof(DrawConstants), count, firstOffset, stride);
+    if (blocks == nullptr) {
+        queue.draws.clear();
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        memcpy(blocks + i * stride, &queue.draws[i].constants, sizeof(DrawConstants));
+    }
+    commitUniformBlocks(uniforms);
+
+    stateBindVertexArray(vao);
+    for (int i = 0; i < count; i++) {
+        const ShadedDraw& draw = queue.draws[i];
+        ShaderVariant& variant = permutations.variants[draw.variant];
+        // точки привязки блоков задаются после сборки, до первого рисования ее нужно дождаться
+        if (!variant.ready) {
+            variant.failed = !waitShaderProgram(variant.handle);
+            variant.ready = true;
+        }
+        if (variant.failed) {
+            continue;
+        }
+        stateUseProgram(variant.program);
+        bindUniformBlock(uniforms, UNIFORM_DRAW_CONSTANTS, firstOffset + i * stride, sizeof(DrawConstants));
+        glDrawArrays(GL_TRIANGLES, draw.first, draw.count);
+    }
+    queue.draws.clear();
+}
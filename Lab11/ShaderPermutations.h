@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ShaderPipeline.h"
+#include "UniformBuffers.h"
+
+// варианты одной пары шейдеров: исходники общие, различия задаются #define,
+// которые вставляются сразу после строки #version. Набор признаков сначала
+// приводится к каноническому виду (признаки, которых нет в исходниках или
+// которые перекрыты другими, отбрасываются), поэтому одинаковые варианты
+// собираются один раз
+
+enum ShadingFeature {
+    SHADING_UNIFORM_COLOR = 1 << 0,  // UNIFORM_COLOR: цвет uColor из блока DrawConstants
+    SHADING_VERTEX_COLOR = 1 << 1,   // VERTEX_COLOR: цвет вершины в location 1, перекрывает uColor
+    SHADING_DRAW_TRANSFORM = 1 << 2  // DRAW_TRANSFORM: сдвиг, масштаб и поворот из DrawConstants
+};
+
+// три вида закрашивания из README
+enum ShadingMode {
+    SHADING_FLAT_CONSTANT,  // цвет задан константой в шейдере
+    SHADING_FLAT_UNIFORM,   // цвет из программы через uniform
+    SHADING_GRADIENT,       // цвета вершин интерполируются
+    SHADING_MODE_COUNT
+};
+
+unsigned int shadingModeFeatures(ShadingMode mode);
+const char* shadingModeName(ShadingMode mode);
+
+struct ShaderVariant {
+    unsigned int features = 0;  // канонический набор признаков
+    ProgramHandle handle = 0;
+    unsigned int program = 0;
+    bool ready = false;  // сборка закончена, блоки привязаны к своим точкам
+    bool failed = false; // сборка не удалась, вызовы варианта пропускаются
+    // программа из новых исходников; заменит program только после успешной сборки
+    ProgramHandle pendingHandle = INVALID_PROGRAM_HANDLE;
+};
+
+struct ShaderPermutations {
+    std::string vertexSource;
+    std::string fragmentSource;
+    unsigned int usedFeatures = 0;  // признаки, упомянутые в исходниках
+    std::vector<ShaderVariant> variants;
+    std::map<unsigned int, int> variantIndex;  // канонический набор -> вариант
+    int lookups = 0;  // все запросы вариантов, включая найденные в кэше
+};
+
+void createShaderPermutations(ShaderPermutations& permutations, const char* vertexSource, const char* fragmentSource);
+void destroyShaderPermutations(ShaderPermutations& permutations);
+
+// набор без лишних признаков; варианты с одинаковым каноническим набором совпадают
+unsigned int canonicalShaderFeatures(const ShaderPermutations& permutations, unsigned int features);
+
+// индекс варианта; при первом запросе программа отправляется на сборку
+// (ShaderPipeline.h) и дальше берется из кэша
+int getShaderVariant(ShaderPermutations& permutations, unsigned int features);
+unsigned int shaderVariantProgram(ShaderPermutations& permutations, unsigned int features);
+
+// новые исходники: все варианты отправляются на сборку заново, а до ее конца
+// рисуют старые программы. Признаки, упомянутые в исходниках, не пересчитываются
+void reloadShaderPermutations(ShaderPermutations& permutations, const std::string& vertexSource,
+    const std::string& fragmentSource);
+
+// вызывается раз за кадр после pollShaderPrograms: варианты, сборка которых
+// закончена, переходят на новую программу; при ошибке сборки остается старая.
+// Готовность только проверяется, сборка здесь не ожидается. Без потоков
+// драйвера и второго контекста pollShaderPrograms выполняет по одному шагу
+// сборки за кадр. Возвращает число замен
+int updateShaderPermutations(ShaderPermutations& permutations);
+
+// очередь рисования с выбором варианта на каждый вызов. При отправке вызовы
+// устойчиво сортируются по варианту, так что программа меняется не чаще,
+// чем число разных вариантов в очереди. Константы всех вызовов пишутся в
+// кольцо uniform-буфера одной порцией, каждый вызов привязывает свой участок.
+// Порядок наложения сохраняется только внутри варианта, поэтому вызовы разных
+// вариантов не должны перекрываться
+struct ShadedDraw {
+    int variant = 0;
+    DrawConstants constants;  // цвет нужен только для SHADING_FLAT_UNIFORM
+    int first = 0;  // вершины GL_TRIANGLES в vao
+    int count = 0;
+};
+
+struct ShadedDrawQueue {
+    std::vector<ShadedDraw> draws;
+    int programSwitches = 0;          // при последней отправке
+    int unsortedProgramSwitches = 0;  // сколько было бы без сортировки
+};
+
+// вариант выбирается по mode с признаком SHADING_DRAW_TRANSFORM
+void addShadedDraw(ShadedDrawQueue& queue, ShaderPermutations& permutations, ShadingMode mode,
+    const DrawConstants& constants, int first, int count);
+
+// рисует все вызовы из вершинного массива vao и очищает очередь
+void flushShadedDraws(ShadedDrawQueue& queue, ShaderPermutations& permutations, UniformRing& uniforms, unsigned int vao);
@@ -0,0 +1,524 @@
+﻿#include "ShaderPipeline.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ProgramCache.h"
+#include "UniformBuffers.h"
+
+enum PipelineMode {
+    PIPELINE_DRIVER_THREADS,  // KHR/ARB_parallel_shader_compile
+    PIPELINE_WORKER_CONTEXT,  // свой поток со вторым контекстом
+    PIPELINE_MAIN_THREAD      // запасной путь: по одному шагу сборки за кадр
+};
+
+// на запасном пути статус запрашивается не раньше этого числа опросов после
+// отправки сборки: драйвер, который собирает лениво, успевает сделать работу между кадрами
+const int MAIN_THREAD_DELAY_POLLS = 3;
+
+// шаги сборки на запасном пути; в остальных режимах программа сразу в STEP_STATUS
+enum MainThreadStep {
+    STEP_COMPILE_VERTEX,
+    STEP_COMPILE_FRAGMENT,
+    STEP_LINK,
+    STEP_STATUS
+};
+
+enum PipelineStage {
+    STAGE_LINKING,   // отправлена, статус еще не запрашивался
+    STAGE_READY,
+    STAGE_FAILED
+};
+
+struct PipelineProgram {
+    unsigned int program = 0;
+    unsigned int vertexShader = 0;    // в основном контексте; на потоке сборки шейдеры его собственные
+    unsigned int fragmentShader = 0;
+    uint64_t cacheKey = 0;
+    PipelineStage stage = STAGE_LINKING;
+    bool onWorker = false;
+    MainThreadStep step = STEP_STATUS;
+    std::string vertexSource;    // запасной путь: исходники до своего шага
+    std::string fragmentSource;
+    int polls = 0;
+};
+
+// задание потоку сборки: программа создана в основном контексте, шейдеры
+// создаются и удаляются в контексте потока
+struct CompileJob {
+    ProgramHandle handle;
+    unsigned int program;
+    std::string vertexSource;
+    std::string fragmentSource;
+    bool retrievable;
+};
+
+struct CompileResult {
+    ProgramHandle handle;
+    bool success;
+    std::string log;
+};
+
+static std::vector<PipelineProgram> programs;
+// записи удаленных программ; перезагрузки шейдеров берут их заново, и список
+// не растет с каждой правкой
+static std::vector<ProgramHandle> freeEntries;
+static PipelineMode mode = PIPELINE_MAIN_THREAD;
+static int pendingCount = 0;
+// начало промежутка, пока есть несобранные программы; сборки идут
+// параллельно, поэтому считается общее время, а не сумма по программам
+static std::chrono::steady_clock::time_point pendingSince;
+
+static GLFWwindow* workerWindow = nullptr;
+static std::thread* worker = nullptr;
+static std::mutex workerMutex;
+static std::condition_variable workerWake;   // новое задание или остановка
+static std::condition_variable jobFinished;
+static std::deque<CompileJob> jobs;
+static std::vector<CompileResult> results;
+static ProgramHandle runningJob = INVALID_PROGRAM_HANDLE;
+static bool stopWorker = false;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void addPending() {
+    if (pendingCount == 0) {
+        pendingSince = std::chrono::steady_clock::now();
+    }
+    pendingCount++;
+}
+
+static void removePending() {
+    pendingCount--;
+    if (pendingCount == 0) {
+        recordProgramCompileTime(millisecondsSince(pendingSince));
+    }
+}
+
+static unsigned int submitShader(unsigned int type, const char* source) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+static void appendShaderLog(unsigned int shader, const char* kind, std::string& log) {
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        log += std::string(kind) + " shader compilation error:\n" + infoLog + "\n";
+    }
+}
+
+// сборка с ожиданием статуса; шейдеры удаляются. Возвращает успех и лог ошибок
+static bool linkProgram(unsigned int program, unsigned int vertexShader, unsigned int fragmentShader, std::string& log) {
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        appendShaderLog(vertexShader, "Vertex", log);
+        appendShaderLog(fragmentShader, "Fragment", log);
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        log += std::string("Program linking error:\n") + infoLog;
+    }
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return success != 0;
+}
+
+static CompileResult compileOnWorker(const CompileJob& job) {
+    CompileResult result;
+    result.handle = job.handle;
+    unsigned int vertexShader = submitShader(GL_VERTEX_SHADER, job.vertexSource.c_str());
+    unsigned int fragmentShader = submitShader(GL_FRAGMENT_SHADER, job.fragmentSource.c_str());
+    if (job.retrievable) {
+        glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(job.program, vertexShader);
+    glAttachShader(job.program, fragmentShader);
+    glLinkProgram(job.program);
+    result.success = linkProgram(job.program, vertexShader, fragmentShader, result.log);
+    // изменения объекта видны другому контексту после glFinish здесь и новой привязки там
+    glFinish();
+    return result;
+}
+
+static void workerLoop() {
+    glfwMakeContextCurrent(workerWindow);
+    std::unique_lock<std::mutex> lock(workerMutex);
+    while (true) {
+        workerWake.wait(lock, [] { return stopWorker || !jobs.empty(); });
+        if (stopWorker) {
+            break;
+        }
+        CompileJob job = jobs.front();
+        jobs.pop_front();
+        runningJob = job.handle;
+        lock.unlock();
+
+        CompileResult result = compileOnWorker(job);
+
+        lock.lock();
+        runningJob = INVALID_PROGRAM_HANDLE;
+        results.push_back(result);
+        jobFinished.notify_all();
+    }
+    lock.unlock();
+    glfwMakeContextCurrent(nullptr);
+}
+
+void initShaderPipeline(GLFWwindow* window) {
+    if (GLEW_KHR_parallel_shader_compile) {
+        // 0xFFFFFFFF - число потоков выбирает драйвер
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        mode = PIPELINE_DRIVER_THREADS;
+        return;
+    }
+    if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        mode = PIPELINE_DRIVER_THREADS;
+        return;
+    }
+
+    // невидимое окно нужно только ради контекста; подсказки версии остались от основного окна
+    mode = PIPELINE_MAIN_THREAD;
+    if (window == nullptr) {
+        return;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    workerWindow = glfwCreateWindow(1, 1, "Shader compiler", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (workerWindow == nullptr) {
+        return;
+    }
+    stopWorker = false;
+    worker = new std::thread(workerLoop);
+    mode = PIPELINE_WORKER_CONTEXT;
+}
+
+void shutdownShaderPipeline() {
+    if (worker == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopWorker = true;
+        jobs.clear();
+    }
+    workerWake.notify_all();
+    worker->join();
+    delete worker;
+    worker = nullptr;
+    glfwDestroyWindow(workerWindow);
+    workerWindow = nullptr;
+    results.clear();
+    mode = PIPELINE_MAIN_THREAD;
+}
+
+const char* shaderPipelineModeName() {
+    switch (mode) {
+    case PIPELINE_DRIVER_THREADS:
+        return "driver threads (parallel_shader_compile)";
+    case PIPELINE_WORKER_CONTEXT:
+        return "worker thread with a shared context";
+    default:
+        return "main thread, one build step per frame";
+    }
+}
+
+// свободная запись до заполнения выглядит удаленной программой
+static ProgramHandle allocateProgramEntry() {
+    if (!freeEntries.empty()) {
+        ProgramHandle handle = freeEntries.back();
+        freeEntries.pop_back();
+        return handle;
+    }
+    PipelineProgram released;
+    released.stage = STAGE_FAILED;
+    programs.push_back(released);
+    return (ProgramHandle)(programs.size() - 1);
+}
+
+ProgramHandle submitShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+    PipelineProgram entry;
+    ProgramHandle handle = allocateProgramEntry();
+    if (programCacheEnabled()) {
+        entry.cacheKey = programCacheKey(vertexShaderSource, fragmentShaderSource);
+        entry.program = loadCachedProgram(entry.cacheKey);
+        if (entry.program) {
+            entry.stage = STAGE_READY;
+            resolveProgramUniforms(entry.program);
+            programs[handle] = entry;
+            return handle;
+        }
+    }
+    entry.program = glCreateProgram();
+    addPending();
+    if (mode == PIPELINE_WORKER_CONTEXT) {
+        entry.onWorker = true;
+        CompileJob job;
+        job.handle = handle;
+        job.program = entry.program;
+        job.vertexSource = vertexShaderSource;
+        job.fragmentSource = fragmentShaderSource;
+        job.retrievable = programCacheEnabled();
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            jobs.push_back(job);
+        }
+        workerWake.notify_one();
+    }
+    else if (mode == PIPELINE_MAIN_THREAD) {
+        // шаги выполняет pollShaderPrograms, по одному за кадр
+        entry.step = STEP_COMPILE_VERTEX;
+        entry.vertexSource = vertexShaderSource;
+        entry.fragmentSource = fragmentShaderSource;
+    }
+    else {
+        // компиляция и сборка отправляются подряд, статусы не запрашиваются
+        entry.vertexShader = submitShader(GL_VERTEX_SHADER, vertexShaderSource);
+        entry.fragmentShader = submitShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+        if (programCacheEnabled()) {
+            glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(entry.program, entry.vertexShader);
+        glAttachShader(entry.program, entry.fragmentShader);
+        glLinkProgram(entry.program);
+    }
+
+    programs[handle] = entry;
+    return handle;
+}
+
+unsigned int shaderProgramObject(ProgramHandle handle) {
+    return programs[handle].program;
+}
+
+// общая часть завершения: кэш, положения uniform, ошибки, статистика
+static void completeProgram(PipelineProgram& entry, bool success, const std::string& log) {
+    if (success) {
+        entry.stage = STAGE_READY;
+        resolveProgramUniforms(entry.program);
+        storeCachedProgram(entry.cacheKey, entry.program);
+    }
+    else {
+        entry.stage = STAGE_FAILED;
+        std::cout << log << std::endl;
+    }
+    recordProgramCompile();
+    removePending();
+}
+
+// запрашивает статус сборки в основном контексте (может блокировать)
+static void finishProgram(PipelineProgram& entry) {
+    std::string log;
+    bool success = linkProgram(entry.program, entry.vertexShader, entry.fragmentShader, log);
+    entry.vertexShader = 0;
+    entry.fragmentShader = 0;
+    completeProgram(entry, success, log);
+}
+
+// запасной путь: выполняет следующий шаг сборки, последний шаг ждет статуса
+static void advanceProgram(PipelineProgram& entry) {
+    switch (entry.step) {
+    case STEP_COMPILE_VERTEX:
+        entry.vertexShader = submitShader(GL_VERTEX_SHADER, entry.vertexSource.c_str());
+        entry.vertexSource.clear();
+        entry.step = STEP_COMPILE_FRAGMENT;
+        break;
+    case STEP_COMPILE_FRAGMENT:
+        entry.fragmentShader = submitShader(GL_FRAGMENT_SHADER, entry.fragmentSource.c_str());
+        entry.fragmentSource.clear();
+        entry.step = STEP_LINK;
+        break;
+    case STEP_LINK:
+        if (programCacheEnabled()) {
+            glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(entry.program, entry.vertexShader);
+        glAttachShader(entry.program, entry.fragmentShader);
+        glLinkProgram(entry.program);
+        entry.step = STEP_STATUS;
+        entry.polls = 0;
+        break;
+    case STEP_STATUS:
+        finishProgram(entry);
+        break;
+    }
+}
+
+// забирает готовые результаты потока сборки; не блокирует
+static void collectWorkerResults() {
+    std::vector<CompileResult> finished;
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        finished.swap(results);
+    }
+    for (const CompileResult& result : finished) {
+        PipelineProgram& entry = programs[result.handle];
+        if (entry.stage == STAGE_LINKING) {
+            completeProgram(entry, result.success, result.log);
+        }
+    }
+}
+
+static bool hasWorkerResult(ProgramHandle handle) {
+    for (const CompileResult& result : results) {
+        if (result.handle == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isShaderProgramReady(ProgramHandle handle) {
+    PipelineProgram& entry = programs[handle];
+    if (entry.stage != STAGE_LINKING) {
+        return true;
+    }
+    if (entry.onWorker) {
+        collectWorkerResults();
+        return entry.stage != STAGE_LINKING;
+    }
+    if (mode != PIPELINE_DRIVER_THREADS) {
+        return false;
+    }
+    int completed;
+    glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &completed);
+    if (completed) {
+        finishProgram(entry);
+    }
+    return completed != 0;
+}
+
+bool waitShaderProgram(ProgramHandle handle) {
+    PipelineProgram& entry = programs[handle];
+    if (entry.stage == STAGE_LINKING) {
+        if (entry.onWorker) {
+            {
+                std::unique_lock<std::mutex> lock(workerMutex);
+                jobFinished.wait(lock, [handle] { return hasWorkerResult(handle); });
+            }
+            collectWorkerResults();
+        }
+        else {
+            while (entry.stage == STAGE_LINKING) {
+                advanceProgram(entry);
+            }
+        }
+    }
+    return entry.stage == STAGE_READY;
+}
+
+bool isShaderProgramLinking(unsigned int program) {
+    if (pendingCount == 0 || program == 0) {
+        return false;
+    }
+    for (const PipelineProgram& entry : programs) {
+        if (entry.program == program && entry.stage == STAGE_LINKING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void prepareShaderProgram(unsigned int program) {
+    if (pendingCount == 0 || program == 0) {
+        return;
+    }
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (programs[i].program == program && programs[i].stage == STAGE_LINKING) {
+            waitShaderProgram((ProgramHandle)i);
+            return;
+        }
+    }
+}
+
+void pollShaderPrograms() {
+    if (mode == PIPELINE_WORKER_CONTEXT) {
+        collectWorkerResults();
+        return;
+    }
+    bool advancedOne = false;
+    for (size_t i = 0; i < programs.size() && pendingCount > 0; i++) {
+        PipelineProgram& entry = programs[i];
+        if (entry.stage != STAGE_LINKING) {
+            continue;
+        }
+        if (mode == PIPELINE_DRIVER_THREADS) {
+            isShaderProgramReady((ProgramHandle)i);
+            continue;
+        }
+        // запасной путь: компиляция и запрос статуса могут блокировать,
+        // поэтому за кадр выполняется один шаг одной программы
+        if (entry.step == STEP_STATUS) {
+            entry.polls++;
+        }
+        if (!advancedOne && (entry.step != STEP_STATUS || entry.polls > MAIN_THREAD_DELAY_POLLS)) {
+            advanceProgram(entry);
+            advancedOne = true;
+        }
+    }
+}
+
+int pendingShaderPrograms() {
+    return pendingCount;
+}
+
+void forgetShaderProgram(unsigned int program) {
+    forgetProgramUniforms(program);
+    // у освобожденных записей имя 0, их трогать нельзя
+    if (program == 0) {
+        return;
+    }
+    // имя программы после удаления может быть выдано заново, запись больше не нужна
+    for (size_t i = 0; i < programs.size(); i++) {
+        PipelineProgram& entry = programs[i];
+        if (entry.program != program) {
+            continue;
+        }
+        if (entry.stage == STAGE_LINKING) {
+            if (entry.onWorker) {
+                // задание убирается из очереди; начатое дожидается конца, чтобы
+                // поток не собирал удаленную программу
+                ProgramHandle handle = (ProgramHandle)i;
+                std::unique_lock<std::mutex> lock(workerMutex);
+                jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                    [handle](const CompileJob& job) { return job.handle == handle; }), jobs.end());
+                jobFinished.wait(lock, [handle] { return runningJob != handle; });
+                results.erase(std::remove_if(results.begin(), results.end(),
+                    [handle](const CompileResult& result) { return result.handle == handle; }), results.end());
+            }
+            else {
+                // до шага сборки шейдеры еще не присоединены, а часть еще не создана
+                if (entry.step == STEP_STATUS) {
+                    glDetachShader(entry.program, entry.vertexShader);
+                    glDetachShader(entry.program, entry.fragmentShader);
+                }
+                glDeleteShader(entry.vertexShader);
+                glDeleteShader(entry.fragmentShader);
+                entry.vertexSource.clear();
+                entry.fragmentSource.clear();
+            }
+            removePending();
+        }
+        entry = PipelineProgram();
+        entry.stage = STAGE_FAILED;
+        freeEntries.push_back((ProgramHandle)i);
+    }
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+// неблокирующая сборка программ: все шейдеры и программы сначала отправляются,
+// а статус запрашивается позже. Способ выбирается при запуске:
+// - с GL_KHR_parallel_shader_compile (или ARB) драйвер собирает программы в
+//   своих потоках, готовность проверяется через GL_COMPLETION_STATUS_KHR;
+// - без расширения сборка идет в отдельном потоке со вторым контекстом GLFW,
+//   разделяющим объекты с основным, и готовая программа видна основному потоку;
+// - если второй контекст создать не удалось, сборка идет в основном потоке по
+//   шагам, один шаг за кадр: компиляция вершинного шейдера, фрагментного,
+//   отправка сборки и, не раньше чем через несколько кадров, запрос статуса.
+// Имя программы действительно сразу; stateUseProgram для незаконченной
+// программы дожидается ее (GLState.h), как glUseProgram в одном контексте.
+
+struct GLFWwindow;
+
+typedef int ProgramHandle;
+const ProgramHandle INVALID_PROGRAM_HANDLE = -1;
+
+// вызывается один раз после создания контекста window и glewInit
+void initShaderPipeline(GLFWwindow* window);
+// останавливает поток сборки; вызывается до glfwTerminate
+void shutdownShaderPipeline();
+const char* shaderPipelineModeName();
+
+// отправляет программу на сборку (или берет из дискового кэша) и сразу возвращается
+ProgramHandle submitShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+// имя программы GL, действительно сразу после submitShaderProgram
+unsigned int shaderProgramObject(ProgramHandle handle);
+
+// true, если сборка закончена (успешно или нет); не блокирует
+bool isShaderProgramReady(ProgramHandle handle);
+
+// дожидается сборки; false, если она не удалась (лог уже напечатан)
+bool waitShaderProgram(ProgramHandle handle);
+
+// true, пока сборка программы с этим именем не закончена; не блокирует
+bool isShaderProgramLinking(unsigned int program);
+
+// если программа еще собирается, дожидается ее; вызывается перед glUseProgram
+void prepareShaderProgram(unsigned int program);
+
+// завершает собранные программы: печатает ошибки, сохраняет в кэш,
+// запоминает положения uniform (UniformBuffers.h). Вызывается раз за кадр
+// и сам не ждет сборки
+void pollShaderPrograms();
+int pendingShaderPrograms();
+
+// владелец удаляет программу: незаконченная сборка отменяется, а ее
+// дескриптор может быть выдан следующей submitShaderProgram
+void forgetShaderProgram(unsigned int program);
@@ -0,0 +1,104 @@
+﻿#include "ShaderWatcher.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__linux__)
+static double secondsNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+bool createShaderWatcher(ShaderWatcher& watcher, const std::string& directory) {
+    watcher.directory = directory;
+#ifdef _WIN32
+    // редакторы часто сохраняют через новый файл и переименование
+    HANDLE notification = FindFirstChangeNotificationA(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (notification == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    watcher.notification = notification;
+#elif defined(__linux__)
+    watcher.descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher.descriptor < 0) {
+        return false;
+    }
+    if (inotify_add_watch(watcher.descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(watcher.descriptor);
+        watcher.descriptor = -1;
+        return false;
+    }
+#else
+    watcher.lastPoll = secondsNow();
+#endif
+    watcher.active = true;
+    return true;
+}
+
+void destroyShaderWatcher(ShaderWatcher& watcher) {
+    if (!watcher.active) {
+        return;
+    }
+#ifdef _WIN32
+    FindCloseChangeNotification((HANDLE)watcher.notification);
+    watcher.notification = nullptr;
+#elif defined(__linux__)
+    close(watcher.descriptor);
+    watcher.descriptor = -1;
+#endif
+    watcher.active = false;
+}
+
+bool pollShaderWatcher(ShaderWatcher& watcher) {
+    if (!watcher.active) {
+        return false;
+    }
+#ifdef _WIN32
+    bool changed = false;
+    // несколько уведомлений подряд сливаются в одно
+    while (WaitForSingleObject((HANDLE)watcher.notification, 0) == WAIT_OBJECT_0) {
+        changed = true;
+        if (!FindNextChangeNotification((HANDLE)watcher.notification)) {
+            destroyShaderWatcher(watcher);
+            break;
+        }
+    }
+    return changed;
+#elif defined(__linux__)
+    bool changed = false;
+    char events[4096];
+    while (read(watcher.descriptor, events, sizeof(events)) > 0) {
+        changed = true;
+    }
+    return changed;
+#else
+    double now = secondsNow();
+    if (now - watcher.lastPoll < 1.0) {
+        return false;
+    }
+    watcher.lastPoll = now;
+    return true;
+#endif
+}
+
+bool loadShaderFile(const std::string& path, std::string& source) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    source = text.str();
+    // компиляторы GLSL не принимают метку порядка байтов, которую оставляют некоторые редакторы
+    if (source.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        source.erase(0, 3);
+    }
+    return true;
+}
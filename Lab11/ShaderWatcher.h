@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <string>
+
+// слежение за каталогом с исходниками шейдеров: inotify в Linux,
+// FindFirstChangeNotification в Windows, на остальных системах - опрос раз
+// в секунду. Проверка не блокирует и вызывается раз за кадр
+struct ShaderWatcher {
+    std::string directory;
+    bool active = false;
+#ifdef _WIN32
+    void* notification = nullptr;  // HANDLE
+#else
+    int descriptor = -1;  // inotify
+    double lastPoll = 0.0;
+#endif
+};
+
+bool createShaderWatcher(ShaderWatcher& watcher, const std::string& directory);
+void destroyShaderWatcher(ShaderWatcher& watcher);
+
+// true, если в каталоге что-то менялось после прошлой проверки; что именно
+// изменилось, вызывающий узнает, перечитав свои файлы
+bool pollShaderWatcher(ShaderWatcher& watcher);
+
+// читает файл целиком без метки UTF-8 в начале; false, если его нет
+bool loadShaderFile(const std::string& path, std::string& source);
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+// вершины фигур с постоянными параметрами, посчитанные при компиляции.
+// Таблицы попадают в секцию только для чтения: нет ни работы при запуске,
+// ни инициализации статиков внутри функций.
+
+constexpr double SHAPE_PI = 3.14159265358979323846;
+
+// синус рядом Тейлора; аргумент сначала приводится к [-pi/2, pi/2],
+// на этом отрезке 8 членов ряда дают ошибку меньше 1e-10
+constexpr double constexprSine(double x) {
+    double turns = x / (2.0 * SHAPE_PI);
+    long long whole = (long long)(turns >= 0.0 ? turns + 0.5 : turns - 0.5);
+    x -= whole * 2.0 * SHAPE_PI;
+    if (x > SHAPE_PI / 2.0) {
+        x = SHAPE_PI - x;
+    }
+    else if (x < -SHAPE_PI / 2.0) {
+        x = -SHAPE_PI - x;
+    }
+
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 8; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCosine(double x) {
+    return constexprSine(x + SHAPE_PI / 2.0);
+}
+
+// массив треугольников (пары x, y) из Vertices вершин
+template <int Vertices>
+struct ShapeTable {
+    float vertices[Vertices * 2];
+};
+
+template <int Vertices>
+constexpr int shapeTableVertexCount(const ShapeTable<Vertices>&) {
+    return Vertices;
+}
+
+// веер правильного многоугольника из центра, как writeRegularPolygon без поворота;
+// последняя точка берется по индексу 0, чтобы контур замыкался точно
+template <int Sides>
+constexpr ShapeTable<Sides * 3> makeRegularPolygonTable(float radius) {
+    ShapeTable<Sides * 3> table{};
+    for (int i = 0; i < Sides; i++) {
+        double angle1 = 2.0 * SHAPE_PI * i / Sides;
+        double angle2 = 2.0 * SHAPE_PI * ((i + 1) % Sides) / Sides;
+        table.vertices[i * 6] = 0.0f;
+        table.vertices[i * 6 + 1] = 0.0f;
+        table.vertices[i * 6 + 2] = radius * (float)constexprCosine(angle1);
+        table.vertices[i * 6 + 3] = radius * (float)constexprSine(angle1);
+        table.vertices[i * 6 + 4] = radius * (float)constexprCosine(angle2);
+        table.vertices[i * 6 + 5] = radius * (float)constexprSine(angle2);
+    }
+    return table;
+}
+
+// четырехугольник
+constexpr ShapeTable<6> QUAD_SHAPE = { {
+    -0.5f,  0.5f,  // левый верхний
+    -0.5f, -0.5f,  // левый нижний
+     0.5f, -0.5f,  // правый нижний
+
+    -0.5f,  0.5f,  // левый верхний
+     0.5f, -0.5f,  // правый нижний
+     0.5f,  0.5f   // правый верхний
+} };
+
+// веер
+constexpr ShapeTable<8 * 3> FAN_SHAPE = makeRegularPolygonTable<8>(0.7f);
+
+// пятиугольник
+constexpr ShapeTable<5 * 3> PENTAGON_SHAPE = makeRegularPolygonTable<5>(0.5f);
+
+// если вычисление перестанет быть constexpr, сборка упадет здесь, а не молча уйдет в рантайм
+static_assert(FAN_SHAPE.vertices[2] > 0.6999f && FAN_SHAPE.vertices[2] < 0.7001f, "fan table is not evaluated at compile time");
+static_assert(PENTAGON_SHAPE.vertices[5] > 0.4755f && PENTAGON_SHAPE.vertices[5] < 0.4756f, "pentagon table is not evaluated at compile time");
@@ -0,0 +1,190 @@
+﻿#include "SimdTrig.h"
+#include <cassert>  // glm/simd/neon.h использует assert, но сам его не подключает
+#include <cmath>
+
+// без GLM_FORCE_INTRINSICS platform.h не подключает интринсики и не выставляет биты SIMD
+#define GLM_FORCE_INTRINSICS
+#include <glm/simd/platform.h>
+
+// pi/2, разбитое на три части (Cody-Waite): у первых двух мало значащих бит,
+// поэтому произведения на номер четверти вычитаются без потери точности
+static const float TWO_OVER_PI = 0.636619772f;
+static const float HALF_PI_HIGH = 1.5703125f;
+static const float HALF_PI_MIDDLE = 4.837512969970703125e-4f;
+static const float HALF_PI_LOW = 7.54978995489188216e-8f;
+
+// коэффициенты Cephes sinf/cosf на [-pi/4, pi/4]
+static const float SIN_C1 = -1.9515295891e-4f;
+static const float SIN_C2 = 8.3321608736e-3f;
+static const float SIN_C3 = -1.6666654611e-1f;
+static const float COS_C1 = 2.443315711809948e-5f;
+static const float COS_C2 = -1.388731625493765e-3f;
+static const float COS_C3 = 4.166664568298827e-2f;
+
+// четверть q: 1 и 3 меняют sin и cos местами, знак sin меняется при q & 2,
+// знак cos при (q + 1) & 2
+void sincosScalar(float angle, float& sine, float& cosine) {
+    int quadrant = (int)std::lround(angle * TWO_OVER_PI);
+    float x = angle - quadrant * HALF_PI_HIGH;
+    x = x - quadrant * HALF_PI_MIDDLE;
+    x = x - quadrant * HALF_PI_LOW;
+    float x2 = x * x;
+
+    float s = ((SIN_C1 * x2 + SIN_C2) * x2 + SIN_C3) * x2 * x + x;
+    float c = ((COS_C1 * x2 + COS_C2) * x2 + COS_C3) * x2 * x2 - 0.5f * x2 + 1.0f;
+
+    if (quadrant & 1) {
+        float swap = s;
+        s = c;
+        c = swap;
+    }
+    sine = (quadrant & 2) ? -s : s;
+    cosine = ((quadrant + 1) & 2) ? -c : c;
+}
+
+#if GLM_ARCH & GLM_ARCH_AVX2_BIT
+
+static const int SIMD_WIDTH = 8;
+
+static void sincosBlock(const float* angles, float* sines, float* cosines) {
+    __m256 angle = _mm256_loadu_ps(angles);
+    __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(TWO_OVER_PI)));
+    __m256 q = _mm256_cvtepi32_ps(quadrant);
+    __m256 x = _mm256_sub_ps(angle, _mm256_mul_ps(q, _mm256_set1_ps(HALF_PI_HIGH)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(HALF_PI_MIDDLE)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(HALF_PI_LOW)));
+    __m256 x2 = _mm256_mul_ps(x, x);
+
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C1), x2), _mm256_set1_ps(SIN_C2));
+    s = _mm256_add_ps(_mm256_mul_ps(s, x2), _mm256_set1_ps(SIN_C3));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, x2), x), x);
+
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C1), x2), _mm256_set1_ps(COS_C2));
+    c = _mm256_add_ps(_mm256_mul_ps(c, x2), _mm256_set1_ps(COS_C3));
+    c = _mm256_mul_ps(_mm256_mul_ps(c, x2), x2);
+    c = _mm256_add_ps(_mm256_sub_ps(c, _mm256_mul_ps(_mm256_set1_ps(0.5f), x2)), _mm256_set1_ps(1.0f));
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sine = _mm256_blendv_ps(s, c, swap);
+    __m256 cosine = _mm256_blendv_ps(c, s, swap);
+
+    // бит 1 четверти сдвигается в знаковый бит
+    __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+    __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    _mm256_storeu_ps(sines, _mm256_xor_ps(sine, sineSign));
+    _mm256_storeu_ps(cosines, _mm256_xor_ps(cosine, cosineSign));
+}
+
+const char* sincosBatchPath() {
+    return "AVX2";
+}
+
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+static const int SIMD_WIDTH = 4;
+
+static void sincosBlock(const float* angles, float* sines, float* cosines) {
+    glm_vec4 angle = _mm_loadu_ps(angles);
+    glm_ivec4 quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TWO_OVER_PI)));
+    glm_vec4 q = _mm_cvtepi32_ps(quadrant);
+    glm_vec4 x = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_HIGH)));
+    x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_MIDDLE)));
+    x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_LOW)));
+    glm_vec4 x2 = _mm_mul_ps(x, x);
+
+    glm_vec4 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C1), x2), _mm_set1_ps(SIN_C2));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(SIN_C3));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+    glm_vec4 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C1), x2), _mm_set1_ps(COS_C2));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(COS_C3));
+    c = _mm_mul_ps(_mm_mul_ps(c, x2), x2);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(_mm_set1_ps(0.5f), x2)), _mm_set1_ps(1.0f));
+
+    // в SSE2 нет blendv: выбор через and/andnot/or
+    glm_vec4 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    glm_vec4 sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    glm_vec4 cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+    // бит 1 четверти сдвигается в знаковый бит
+    glm_vec4 sineSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    glm_vec4 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    _mm_storeu_ps(sines, _mm_xor_ps(sine, sineSign));
+    _mm_storeu_ps(cosines, _mm_xor_ps(cosine, cosineSign));
+}
+
+const char* sincosBatchPath() {
+    return "SSE2";
+}
+
+#elif GLM_ARCH & GLM_ARCH_NEON_BIT
+
+static const int SIMD_WIDTH = 4;
+
+static void sincosBlock(const float* angles, float* sines, float* cosines) {
+    glm_f32vec4 angle = vld1q_f32(angles);
+    glm_f32vec4 scaled = vmulq_n_f32(angle, TWO_OVER_PI);
+    // округление к ближайшему: прибавить 0.5 со знаком аргумента и отбросить дробь
+    uint32x4_t signBit = vandq_u32(vreinterpretq_u32_f32(scaled), vdupq_n_u32(0x80000000u));
+    glm_f32vec4 half = vreinterpretq_f32_u32(vorrq_u32(signBit, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    glm_i32vec4 quadrant = vcvtq_s32_f32(vaddq_f32(scaled, half));
+    glm_f32vec4 q = vcvtq_f32_s32(quadrant);
+    glm_f32vec4 x = vmlsq_n_f32(angle, q, HALF_PI_HIGH);
+    x = vmlsq_n_f32(x, q, HALF_PI_MIDDLE);
+    x = vmlsq_n_f32(x, q, HALF_PI_LOW);
+    glm_f32vec4 x2 = vmulq_f32(x, x);
+
+    glm_f32vec4 s = vmlaq_f32(vdupq_n_f32(SIN_C2), vdupq_n_f32(SIN_C1), x2);
+    s = vmlaq_f32(vdupq_n_f32(SIN_C3), s, x2);
+    s = vmlaq_f32(x, vmulq_f32(s, x2), x);
+
+    glm_f32vec4 c = vmlaq_f32(vdupq_n_f32(COS_C2), vdupq_n_f32(COS_C1), x2);
+    c = vmlaq_f32(vdupq_n_f32(COS_C3), c, x2);
+    c = vmulq_f32(vmulq_f32(c, x2), x2);
+    c = vaddq_f32(vmlsq_n_f32(c, x2, 0.5f), vdupq_n_f32(1.0f));
+
+    uint32x4_t swap = vceqq_s32(vandq_s32(quadrant, vdupq_n_s32(1)), vdupq_n_s32(1));
+    glm_f32vec4 sine = vbslq_f32(swap, c, s);
+    glm_f32vec4 cosine = vbslq_f32(swap, s, c);
+
+    // бит 1 четверти сдвигается в знаковый бит
+    uint32x4_t sineSign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(quadrant, vdupq_n_s32(2))), 30);
+    uint32x4_t cosineSign = vshlq_n_u32(vreinterpretq_u32_s32(
+        vandq_s32(vaddq_s32(quadrant, vdupq_n_s32(1)), vdupq_n_s32(2))), 30);
+    vst1q_f32(sines, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sine), sineSign)));
+    vst1q_f32(cosines, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cosine), cosineSign)));
+}
+
+const char* sincosBatchPath() {
+    return "NEON";
+}
+
+#else
+
+static const int SIMD_WIDTH = 1;
+
+static void sincosBlock(const float* angles, float* sines, float* cosines) {
+    sincosScalar(angles[0], sines[0], cosines[0]);
+}
+
+const char* sincosBatchPath() {
+    return "scalar";
+}
+
+#endif
+
+void sincosBatch(const float* angles, float* sines, float* cosines, int count) {
+    int i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        sincosBlock(angles + i, sines + i, cosines + i);
+    }
+    for (; i < count; i++) {
+        sincosScalar(angles[i], sines[i], cosines[i]);
+    }
+}
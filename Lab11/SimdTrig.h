@@ -0,0 +1,16 @@
+﻿#pragma once
+
+// пакетный sin/cos для генерации точек на окружности.
+// Аргумент приводится к [-pi/4, pi/4] по четвертям, дальше полиномы Cephes;
+// абсолютная ошибка около 1e-7 при |angle| до нескольких тысяч радиан.
+// Путь выбирается при компиляции по glm/simd/platform.h: AVX2 (8 углов),
+// SSE2 или NEON (по 4 угла), иначе тот же алгоритм по одному углу.
+
+// sines[i] = sin(angles[i]), cosines[i] = cos(angles[i]) для i < count
+void sincosBatch(const float* angles, float* sines, float* cosines, int count);
+
+// тот же алгоритм без векторных инструкций: эталон для сравнения и хвост пакета
+void sincosScalar(float angle, float& sine, float& cosine);
+
+// имя выбранного при компиляции пути: "AVX2", "SSE2", "NEON" или "scalar"
+const char* sincosBatchPath();
@@ -0,0 +1,270 @@
+﻿#include "StencilFill.h"
+#include <GL/glew.h>
+#include <cstring>
+
+#include "GLState.h"
+#include "GpuBackend.h"
+#include "Shader.h"
+
+// фигур в пакете не больше этого: проверка пересечений внутри пакета квадратична
+static const int MAX_BATCH_PATHS = 128;
+
+bool createStencilFiller(StencilFiller& filler, size_t maxBytesPerFrame, UploadMethod uploadMethod) {
+    // одна программа на все проходы: в проходе трафарета запись цвета выключена
+    filler.program = createStrokeProgram();
+    if (!filler.program) {
+        return false;
+    }
+    filler.vertices = createUploadStrategy(uploadMethod);
+    if (!filler.vertices->create(GL_ARRAY_BUFFER, maxBytesPerFrame)) {
+        return false;
+    }
+
+    GpuBackend& backend = gpuBackend();
+    filler.stencilVAO = backend.createVertexArray();
+    backend.setVertexAttribute(filler.stencilVAO, 0, 0, 2, GL_FLOAT, false, 0);
+    filler.coverVAO = backend.createVertexArray();
+    setStrokeVertexFormat(filler.coverVAO);
+    return true;
+}
+
+void destroyStencilFiller(StencilFiller& filler) {
+    gpuBackend().deleteVertexArray(filler.stencilVAO);
+    gpuBackend().deleteVertexArray(filler.coverVAO);
+    filler.vertices->destroy();
+    delete filler.vertices;
+    filler.vertices = nullptr;
+    stateForgetProgram(filler.program);
+    deleteShaderProgram(filler.program);
+    filler.program = 0;
+    filler.stencilVAO = 0;
+    filler.coverVAO = 0;
+}
+
+void beginStencilFrame(StencilFiller& filler) {
+    filler.vertices->beginFrame();
+    filler.fanVertices.clear();
+    filler.coverVertices.clear();
+    filler.strokeVertices.clear();
+    filler.paths.clear();
+}
+
+void endStencilFrame(StencilFiller& filler) {
+    filler.vertices->endFrame();
+}
+
+void addStencilPath(StencilFiller& filler, const std::vector<Contour>& contours,
+    float r, float g, float b, float a, FillRule rule) {
+    if (contours.empty() || contours[0].size() < 6) {
+        return;
+    }
+
+    StencilPath path;
+    path.rule = rule;
+    path.fanFirst = (int)(filler.fanVertices.size() / 2);
+    path.strokeFirst = (int)filler.strokeVertices.size();
+    path.minX = path.maxX = contours[0][0];
+    path.minY = path.maxY = contours[0][1];
+
+    // опорная точка общая для всех контуров: треугольники от нее к каждому ребру
+    // вместе дают число обходов в каждой точке
+    float anchorX = contours[0][0];
+    float anchorY = contours[0][1];
+    for (const Contour& contour : contours) {
+        size_t count = contour.size() / 2;
+        for (size_t i = 0; i < count; i++) {
+            size_t j = (i + 1 == count) ? 0 : i + 1;
+            float x = contour[i * 2];
+            float y = contour[i * 2 + 1];
+            filler.fanVertices.push_back(anchorX);
+            filler.fanVertices.push_back(anchorY);
+            filler.fanVertices.push_back(x);
+            filler.fanVertices.push_back(y);
+            filler.fanVertices.push_back(contour[j * 2]);
+            filler.fanVertices.push_back(contour[j * 2 + 1]);
+
+            path.minX = x < path.minX ? x : path.minX;
+            path.maxX = x > path.maxX ? x : path.maxX;
+            path.minY = y < path.minY ? y : path.minY;
+            path.maxY = y > path.maxY ? y : path.maxY;
+        }
+    }
+    path.fanCount = (int)(filler.fanVertices.size() / 2) - path.fanFirst;
+
+    // прямоугольник закраски: два треугольника с цветом фигуры
+    path.coverFirst = (int)filler.coverVertices.size();
+    path.coverCount = 6;
+    const float corners[6][2] = {
+        { path.minX, path.minY }, { path.maxX, path.minY }, { path.maxX, path.maxY },
+        { path.minX, path.minY }, { path.maxX, path.maxY }, { path.minX, path.maxY }
+    };
+    StrokeVertex vertex = {};
+    packStrokeColor(r, g, b, a, vertex.color);
+    for (int i = 0; i < 6; i++) {
+        vertex.x = corners[i][0];
+        vertex.y = corners[i][1];
+        filler.coverVertices.push_back(vertex);
+    }
+    filler.paths.push_back(path);
+}
+
+void addStencilStroke(StencilFiller& filler, const std::vector<Contour>& contours, bool closed,
+    const StrokeStyle& style, float pixelsPerUnit, bool withLastPath) {
+    size_t first = filler.strokeVertices.size();
+    for (const Contour& contour : contours) {
+        strokePolyline(contour.data(), (int)(contour.size() / 2), closed, style, pixelsPerUnit, filler.strokeVertices);
+    }
+    if (filler.strokeVertices.size() == first) {
+        return;
+    }
+
+    bool attach = withLastPath && !filler.paths.empty();
+    StencilPath path;
+    if (attach) {
+        path = filler.paths.back();
+    }
+    else {
+        // фигура без заливки; правило как у предыдущей, чтобы не рвать пакет
+        path.rule = filler.paths.empty() ? FILL_NONZERO : filler.paths.back().rule;
+        path.fanFirst = (int)(filler.fanVertices.size() / 2);
+        path.coverFirst = (int)filler.coverVertices.size();
+        path.strokeFirst = (int)first;
+        path.minX = path.maxX = filler.strokeVertices[first].x;
+        path.minY = path.maxY = filler.strokeVertices[first].y;
+    }
+    // прямоугольник фигуры растет на ширину обводки, иначе пакеты перекроются
+    for (size_t i = first; i < filler.strokeVertices.size(); i++) {
+        const StrokeVertex& vertex = filler.strokeVertices[i];
+        path.minX = vertex.x < path.minX ? vertex.x : path.minX;
+        path.maxX = vertex.x > path.maxX ? vertex.x : path.maxX;
+        path.minY = vertex.y < path.minY ? vertex.y : path.minY;
+        path.maxY = vertex.y > path.maxY ? vertex.y : path.maxY;
+    }
+    path.strokeCount = (int)(filler.strokeVertices.size() - path.strokeFirst);
+    if (attach) {
+        filler.paths.back() = path;
+    }
+    else {
+        filler.paths.push_back(path);
+    }
+}
+
+static bool boundsOverlap(const StencilPath& a, const StencilPath& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+static void setStencilRule(FillRule rule) {
+    if (rule == FILL_EVEN_ODD) {
+        stateSetStencilMask(0x01);
+        stateSetStencilFunc(GL_ALWAYS, 0, 0x01);
+        stateSetStencilOp(GL_FRONT_AND_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+    }
+    else {
+        // обход против часовой прибавляет единицу, по часовой - вычитает
+        stateSetStencilMask(0xFF);
+        stateSetStencilFunc(GL_ALWAYS, 0, 0xFF);
+        stateSetStencilOp(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+        stateSetStencilOp(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+    }
+}
+
+static void setCoverRule(FillRule rule) {
+    unsigned int mask = rule == FILL_EVEN_ODD ? 0x01 : 0xFF;
+    stateSetStencilMask(mask);
+    stateSetStencilFunc(GL_NOTEQUAL, 0, mask);
+    // за закраской трафарет снова нулевой, следующий пакет начинает с чистого
+    stateSetStencilOp(GL_FRONT_AND_BACK, GL_ZERO, GL_ZERO, GL_ZERO);
+}
+
+void flushStencilFills(StencilFiller& filler) {
+    filler.batches = 0;
+    if (filler.paths.empty()) {
+        return;
+    }
+
+    const size_t fanStride = 2 * sizeof(float);
+    const size_t coverStride = sizeof(StrokeVertex);
+    size_t fanBytes = filler.fanVertices.size() * sizeof(float);
+    size_t coverBytes = filler.coverVertices.size() * coverStride;
+    size_t strokeBytes = filler.strokeVertices.size() * coverStride;
+
+    size_t fanOffset = 0;
+    if (fanBytes > 0) {
+        void* fanMemory = filler.vertices->allocate(fanBytes, fanStride, fanOffset);
+        if (fanMemory == nullptr) {
+            return;
+        }
+        memcpy(fanMemory, filler.fanVertices.data(), fanBytes);
+        filler.vertices->commit();
+    }
+
+    // обводки лежат сразу за прямоугольниками закраски в том же участке
+    size_t coverOffset;
+    char* coverMemory = (char*)filler.vertices->allocate(coverBytes + strokeBytes, coverStride, coverOffset);
+    if (coverMemory == nullptr) {
+        return;
+    }
+    memcpy(coverMemory, filler.coverVertices.data(), coverBytes);
+    memcpy(coverMemory + coverBytes, filler.strokeVertices.data(), strokeBytes);
+    filler.vertices->commit();
+    int strokeBase = (int)filler.coverVertices.size();
+
+    GpuBackend& backend = gpuBackend();
+    backend.setVertexBuffer(filler.stencilVAO, 0, filler.vertices->buffer(), fanOffset, fanStride);
+    backend.setVertexBuffer(filler.coverVAO, 0, filler.vertices->buffer(), coverOffset, coverStride);
+
+    stateUseProgram(filler.program);
+    stateSetStencilTest(true);
+    // края обводок сглажены через альфу
+    stateSetBlend(true);
+    stateSetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    size_t first = 0;
+    while (first < filler.paths.size()) {
+        // пакет продолжается, пока фигуры не перекрываются и правило одно
+        size_t last = first + 1;
+        while (last < filler.paths.size() && last - first < (size_t)MAX_BATCH_PATHS
+            && filler.paths[last].rule == filler.paths[first].rule) {
+            bool overlaps = false;
+            for (size_t i = first; i < last && !overlaps; i++) {
+                overlaps = boundsOverlap(filler.paths[i], filler.paths[last]);
+            }
+            if (overlaps) {
+                break;
+            }
+            last++;
+        }
+
+        const StencilPath& begin = filler.paths[first];
+        const StencilPath& end = filler.paths[last - 1];
+        FillRule rule = begin.rule;
+
+        int fanCount = end.fanFirst + end.fanCount - begin.fanFirst;
+        if (fanCount > 0) {
+            stateSetColorMask(false);
+            setStencilRule(rule);
+            stateBindVertexArray(filler.stencilVAO);
+            glDrawArrays(GL_TRIANGLES, begin.fanFirst, fanCount);
+
+            stateSetColorMask(true);
+            setCoverRule(rule);
+            stateBindVertexArray(filler.coverVAO);
+            glDrawArrays(GL_TRIANGLES, begin.coverFirst, end.coverFirst + end.coverCount - begin.coverFirst);
+        }
+
+        int strokeCount = end.strokeFirst + end.strokeCount - begin.strokeFirst;
+        if (strokeCount > 0) {
+            stateSetStencilTest(false);
+            stateBindVertexArray(filler.coverVAO);
+            glDrawArrays(GL_TRIANGLES, strokeBase + begin.strokeFirst, strokeCount);
+            stateSetStencilTest(true);
+        }
+
+        filler.batches++;
+        first = last;
+    }
+
+    stateSetStencilMask(0xFF);
+    stateSetStencilTest(false);
+    stateSetBlend(false);
+}
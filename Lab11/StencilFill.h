@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <vector>
+
+#include "Stroker.h"
+#include "Triangulator.h"
+#include "UploadStrategy.h"
+
+// заливка произвольных многоугольников без триангуляции на CPU ("stencil, then cover"):
+// каждый контур рисуется веером от одной опорной точки в буфер трафарета, где
+// перекрытия веера дают число обходов, затем прямоугольник вокруг фигуры
+// закрашивается там, где трафарет не ноль. Работа на CPU - O(n) от числа вершин.
+// Обводки (Stroker.h) рисуются в тех же пакетах сразу после закраски.
+// Окну нужен буфер трафарета (GLFW_STENCIL_BITS).
+
+enum FillRule {
+    FILL_NONZERO,   // закрашено, где число обходов не ноль
+    FILL_EVEN_ODD   // закрашено, где число обходов нечетно
+};
+
+// одна фигура кадра: участки веера, прямоугольника и обводки в общих массивах;
+// у фигуры может не быть заливки или обводки
+struct StencilPath {
+    int fanFirst = 0;
+    int fanCount = 0;
+    int coverFirst = 0;
+    int coverCount = 0;
+    int strokeFirst = 0;
+    int strokeCount = 0;
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    FillRule rule = FILL_NONZERO;
+};
+
+struct StencilFiller {
+    unsigned int program = 0;
+    unsigned int stencilVAO = 0;  // только позиции
+    unsigned int coverVAO = 0;    // StrokeVertex для закраски и обводок
+    UploadStrategy* vertices = nullptr;
+    std::vector<float> fanVertices;    // x, y
+    std::vector<StrokeVertex> coverVertices;
+    std::vector<StrokeVertex> strokeVertices;
+    std::vector<StencilPath> paths;
+    int batches = 0;  // пакетов (пар вызовов рисования) в последнем flushStencilFills
+};
+
+bool createStencilFiller(StencilFiller& filler, size_t maxBytesPerFrame, UploadMethod uploadMethod);
+void destroyStencilFiller(StencilFiller& filler);
+
+void beginStencilFrame(StencilFiller& filler);
+void endStencilFrame(StencilFiller& filler);
+
+// добавляет фигуру из одного или нескольких контуров; дыры задаются контурами
+// с обратным обходом (для FILL_NONZERO) или любыми (для FILL_EVEN_ODD)
+void addStencilPath(StencilFiller& filler, const std::vector<Contour>& contours,
+    float r, float g, float b, float a, FillRule rule);
+
+// обводит контуры (замкнутые или открытые ломаные). С withLastPath обводка
+// принадлежит последней добавленной фигуре и рисуется сразу за ее заливкой в
+// том же пакете, иначе это отдельная фигура без заливки
+void addStencilStroke(StencilFiller& filler, const std::vector<Contour>& contours, bool closed,
+    const StrokeStyle& style, float pixelsPerUnit, bool withLastPath);
+
+// рисует накопленные фигуры в порядке добавления. Фигуры с непересекающимися
+// прямоугольниками и одним правилом заливки объединяются в пакет: один вызов
+// на трафарет, один на закраску и один на обводки. Закраска обнуляет трафарет за собой
+void flushStencilFills(StencilFiller& filler);
@@ -0,0 +1,99 @@
+﻿#include "StreamBuffer.h"
+#include <GL/glew.h>
+#include <iostream>
+
+#include "GpuBackend.h"
+
+bool createStreamBuffer(StreamBuffer& stream, unsigned int target, size_t regionSize, bool allowPersistent) {
+    stream.target = target;
+    stream.regionSize = regionSize;
+    stream.region = 0;
+    stream.head = 0;
+
+    GpuBackend& backend = gpuBackend();
+    size_t totalSize = regionSize * STREAM_FRAMES_IN_FLIGHT;
+    void* mapped = nullptr;
+    stream.buffer = allowPersistent ? backend.createPersistentBuffer(totalSize, &mapped) : 0;
+    stream.mapped = (unsigned char*)mapped;
+    stream.persistent = stream.buffer != 0;
+    if (!stream.persistent) {
+        if (allowPersistent && GLEW_ARB_buffer_storage) {
+            std::cout << "Stream buffer: persistent mapping failed, falling back to glMapBufferRange" << std::endl;
+        }
+        stream.buffer = backend.createBuffer(totalSize, nullptr, BUFFER_STREAM);
+    }
+    return stream.buffer != 0;
+}
+
+void destroyStreamBuffer(StreamBuffer& stream) {
+    for (int i = 0; i < STREAM_FRAMES_IN_FLIGHT; i++) {
+        if (stream.fences[i]) {
+            glDeleteSync((GLsync)stream.fences[i]);
+            stream.fences[i] = nullptr;
+        }
+    }
+    GpuBackend& backend = gpuBackend();
+    if (stream.mapped) {
+        backend.unmapBuffer(stream.buffer);
+        stream.mapped = nullptr;
+    }
+    backend.deleteBuffer(stream.buffer);
+    stream.buffer = 0;
+}
+
+void beginStreamFrame(StreamBuffer& stream) {
+    stream.region = (stream.region + 1) % STREAM_FRAMES_IN_FLIGHT;
+    stream.head = 0;
+
+    GLsync fence = (GLsync)stream.fences[stream.region];
+    if (!fence) {
+        return;
+    }
+    // сначала проверяем без ожидания, чтобы посчитать реальные простои
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stream.stalls++;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    stream.fences[stream.region] = nullptr;
+}
+
+void endStreamFrame(StreamBuffer& stream) {
+    if (stream.fences[stream.region]) {
+        glDeleteSync((GLsync)stream.fences[stream.region]);
+    }
+    stream.fences[stream.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* streamAllocate(StreamBuffer& stream, size_t bytes, size_t alignment, size_t& offset) {
+    size_t aligned = (stream.head + alignment - 1) / alignment * alignment;
+    if (aligned + bytes > stream.regionSize) {
+        std::cout << "Stream buffer: region overflow (" << bytes << " bytes requested)" << std::endl;
+        return nullptr;
+    }
+    offset = stream.region * stream.regionSize + aligned;
+    stream.head = aligned + bytes;
+
+    if (stream.persistent) {
+        return stream.mapped + offset;
+    }
+
+    // запасной режим: область защищена fence, поэтому синхронизация драйвера не нужна
+    streamCommit(stream);
+    void* pointer = gpuBackend().mapBufferRange(stream.buffer, offset, bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    stream.mappedOffset = offset;
+    stream.mappedSize = bytes;
+    return pointer;
+}
+
+void streamCommit(StreamBuffer& stream) {
+    if (stream.persistent || stream.mappedSize == 0) {
+        return;
+    }
+    gpuBackend().unmapBuffer(stream.buffer);
+    stream.mappedSize = 0;
+}
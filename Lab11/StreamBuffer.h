@@ -0,0 +1,41 @@
+﻿#pragma once
+#include <cstddef>
+
+// число кадров, которые GPU может обрабатывать одновременно с CPU
+const int STREAM_FRAMES_IN_FLIGHT = 3;
+
+// кольцевой буфер для данных, которые меняются каждый кадр.
+// Буфер делится на STREAM_FRAMES_IN_FLIGHT областей, каждая защищена fence:
+// перед записью в область CPU ждет, пока GPU закончит кадр, который ее читал.
+// При наличии ARB_buffer_storage буфер отображен постоянно и когерентно,
+// иначе каждая запись отображается через glMapBufferRange с инвалидированием.
+struct StreamBuffer {
+    unsigned int buffer = 0;
+    unsigned int target = 0;       // цель привязки, например GL_ARRAY_BUFFER
+    size_t regionSize = 0;
+    int region = 0;                // область текущего кадра
+    size_t head = 0;               // смещение внутри области
+    bool persistent = false;
+    unsigned char* mapped = nullptr;   // постоянное отображение всего буфера
+    size_t mappedOffset = 0;           // отображенный участок в запасном режиме
+    size_t mappedSize = 0;
+    void* fences[STREAM_FRAMES_IN_FLIGHT] = {};
+    int stalls = 0;                // сколько раз пришлось ждать GPU
+};
+
+// target - цель привязки (GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, ...);
+// allowPersistent = false принудительно включает запасной режим с glMapBufferRange
+bool createStreamBuffer(StreamBuffer& stream, unsigned int target, size_t regionSize, bool allowPersistent = true);
+void destroyStreamBuffer(StreamBuffer& stream);
+
+// переходит к следующей области и ждет ее освобождения GPU
+void beginStreamFrame(StreamBuffer& stream);
+// ставит fence после команд кадра, читающих текущую область
+void endStreamFrame(StreamBuffer& stream);
+
+// выделяет bytes байт в текущей области и возвращает указатель прямо
+// в отображенную память; offset - смещение от начала буфера для glVertexAttribPointer и т.п.
+// Возвращает nullptr, если область переполнена.
+void* streamAllocate(StreamBuffer& stream, size_t bytes, size_t alignment, size_t& offset);
+// завершает запись выделенного участка; должна быть вызвана до рисования
+void streamCommit(StreamBuffer& stream);
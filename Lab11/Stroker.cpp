@@ -0,0 +1,400 @@
+﻿#include "Stroker.h"
+#include <cmath>
+#include <cstring>
+
+#include "Shader.h"
+#include "Tessellator.h"
+#include "VertexFormat.h"
+
+static const float PI = 3.14159265f;
+
+static const char* strokeVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in vec4 aStroke;  // across, along, dashOn, dashPeriod
+    layout (location = 3) in vec2 aClip;
+    out vec4 vColor;
+    out vec4 vStroke;
+    out vec2 vClip;
+    void main() {
+        gl_Position = vec4(aPos, 0.0, 1.0);
+        vColor = aColor;
+        vStroke = aStroke;
+        vClip = aClip;
+    }
+)";
+
+// покрытие пикселя считается по расстоянию до края в долях пикселя (fwidth),
+// поэтому полоса сглаживания остается в один пиксель при любом масштабе
+static const char* strokeFragmentShaderSource = R"(
+    #version 330 core
+    in vec4 vColor;
+    in vec4 vStroke;
+    in vec2 vClip;
+    out vec4 FragColor;
+    float edgeCoverage(float inside, float pixel) {
+        return clamp(inside / max(pixel, 1e-6) + 0.5, 0.0, 1.0);
+    }
+    void main() {
+        float coverage = 1.0;
+        float acrossPixel = fwidth(vStroke.x);
+        if (acrossPixel > 0.0) {
+            coverage = edgeCoverage(1.0 - abs(vStroke.x), acrossPixel);
+        }
+        float along = vStroke.y;
+        float alongPixel = fwidth(along);
+        if (vClip.y > vClip.x) {
+            coverage *= edgeCoverage(min(along - vClip.x, vClip.y - along), alongPixel);
+        }
+        if (vStroke.w > 0.0) {
+            // расстояние до ближайшей границы штриха, внутри штриха положительное
+            float phase = mod(along, vStroke.w);
+            float inside = max(min(phase, vStroke.z - phase), phase - vStroke.w);
+            coverage *= edgeCoverage(inside, alongPixel);
+        }
+        if (coverage <= 0.0) {
+            discard;
+        }
+        FragColor = vec4(vColor.rgb, vColor.a * coverage);
+    }
+)";
+
+unsigned int createStrokeProgram() {
+    return createShaderProgram(strokeVertexShaderSource, strokeFragmentShaderSource);
+}
+
+void setStrokeVertexFormat(unsigned int vao) {
+    // атрибуты в порядке полей StrokeVertex
+    VertexFormat format;
+    addFormatAttribute(format, 0, 2, ENCODING_FLOAT32);
+    addFormatAttribute(format, 2, 4, ENCODING_FLOAT32);
+    addFormatAttribute(format, 3, 2, ENCODING_FLOAT32);
+    addFormatAttribute(format, 1, 4, ENCODING_UNORM8);
+    applyVertexFormat(vao, 0, format);
+}
+
+void packStrokeColor(float r, float g, float b, float a, unsigned char color[4]) {
+    uint32_t packed = packColorUnorm8(r, g, b, a);
+    memcpy(color, &packed, sizeof(packed));
+}
+
+// общие значения для всех вершин одного куска обводки
+struct StrokeContext {
+    float lineHalfWidth = 0.0f;
+    float halfWidth = 0.0f;     // с полосой сглаживания
+    float edge = 1.0f;          // across на краю расширенной полосы
+    float fringe = 0.0f;        // один пиксель в единицах координат
+    int circleSegments = 3;     // сегментов на полную окружность скругления
+    LineJoin join = JOIN_MITER;
+    float miterLimit = 4.0f;
+    float dashOn = 0.0f;
+    float dashPeriod = 0.0f;
+    float clipStart = 0.0f;
+    float clipEnd = 0.0f;
+    unsigned char color[4] = {};
+    std::vector<StrokeVertex>* vertices = nullptr;
+};
+
+struct StrokePoint {
+    float x, y;
+    float across, along;
+};
+
+static void emitTriangle(const StrokeContext& context, const StrokePoint& p0, const StrokePoint& p1, const StrokePoint& p2) {
+    const StrokePoint* points[3] = { &p0, &p1, &p2 };
+    for (const StrokePoint* point : points) {
+        StrokeVertex vertex;
+        vertex.x = point->x;
+        vertex.y = point->y;
+        vertex.across = point->across;
+        vertex.along = point->along;
+        vertex.dashOn = context.dashOn;
+        vertex.dashPeriod = context.dashPeriod;
+        vertex.clipStart = context.clipStart;
+        vertex.clipEnd = context.clipEnd;
+        for (int i = 0; i < 4; i++) {
+            vertex.color[i] = context.color[i];
+        }
+        context.vertices->push_back(vertex);
+    }
+}
+
+// прямоугольник отрезка; (nx, ny) - единичная нормаль слева от направления
+static void emitSegment(const StrokeContext& context, float x0, float y0, float along0,
+    float x1, float y1, float along1, float nx, float ny) {
+    float ox = nx * context.halfWidth;
+    float oy = ny * context.halfWidth;
+    StrokePoint left0 = { x0 + ox, y0 + oy, context.edge, along0 };
+    StrokePoint right0 = { x0 - ox, y0 - oy, -context.edge, along0 };
+    StrokePoint left1 = { x1 + ox, y1 + oy, context.edge, along1 };
+    StrokePoint right1 = { x1 - ox, y1 - oy, -context.edge, along1 };
+    emitTriangle(context, left0, right0, right1);
+    emitTriangle(context, left0, right1, left1);
+}
+
+// веер вокруг (x, y) от вектора (fromX, fromY) длиной halfWidth на угол angle
+static void emitArc(const StrokeContext& context, float x, float y, float along,
+    float fromX, float fromY, float angle) {
+    int steps = (int)std::ceil(std::fabs(angle) / (2.0f * PI) * context.circleSegments);
+    steps = steps < 1 ? 1 : steps;
+    float stepCos = std::cos(angle / steps);
+    float stepSin = std::sin(angle / steps);
+
+    StrokePoint center = { x, y, 0.0f, along };
+    StrokePoint previous = { x + fromX, y + fromY, context.edge, along };
+    for (int i = 0; i < steps; i++) {
+        float rotatedX = fromX * stepCos - fromY * stepSin;
+        float rotatedY = fromX * stepSin + fromY * stepCos;
+        fromX = rotatedX;
+        fromY = rotatedY;
+        StrokePoint next = { x + fromX, y + fromY, context.edge, along };
+        emitTriangle(context, center, previous, next);
+        previous = next;
+    }
+}
+
+// соединение в точке (x, y) между отрезками с направлениями (dx0, dy0) и (dx1, dy1);
+// внутреннюю сторону излома закрывают сами прямоугольники отрезков
+static void emitJoin(const StrokeContext& context, float x, float y, float along,
+    float dx0, float dy0, float dx1, float dy1) {
+    float cross = dx0 * dy1 - dy0 * dx1;
+    float dot = dx0 * dx1 + dy0 * dy1;
+    if (std::fabs(cross) < 1e-6f && dot > 0.0f) {
+        return;
+    }
+
+    // при повороте влево внешняя сторона справа
+    float side = cross > 0.0f ? -1.0f : 1.0f;
+    float n0x = -dy0 * side;
+    float n0y = dx0 * side;
+    float n1x = -dy1 * side;
+    float n1y = dx1 * side;
+    float hw = context.halfWidth;
+
+    if (context.join == JOIN_ROUND) {
+        emitArc(context, x, y, along, n0x * hw, n0y * hw, std::atan2(cross, dot));
+        return;
+    }
+
+    StrokePoint center = { x, y, 0.0f, along };
+    StrokePoint outer0 = { x + n0x * hw, y + n0y * hw, context.edge, along };
+    StrokePoint outer1 = { x + n1x * hw, y + n1y * hw, context.edge, along };
+    // отношение длины острия к полуширине: 1 / cos(половины угла поворота)
+    if (context.join == JOIN_MITER && 1.0f + dot > 1e-6f
+        && 2.0f / (1.0f + dot) <= context.miterLimit * context.miterLimit) {
+        // острие лежит на обеих смещенных прямых, и across в треугольниках
+        // (центр, край, острие) меняется линейно точно так же, как расстояние до прямой
+        float k = hw / (1.0f + dot);
+        StrokePoint miter = { x + (n0x + n1x) * k, y + (n0y + n1y) * k, context.edge, along };
+        emitTriangle(context, center, outer0, miter);
+        emitTriangle(context, center, miter, outer1);
+    }
+    else {
+        emitTriangle(context, center, outer0, outer1);
+    }
+}
+
+// обводка ломаной без повторяющихся соседних точек; along первой точки - alongOffset
+// плюс выступ торца
+static void strokeRun(StrokeContext& context, const float* points, int count, bool closed, LineCap cap, float alongOffset) {
+    // штрих нулевой длины со скругленными торцами - точка
+    if (count == 1 && !closed && cap == CAP_ROUND) {
+        context.clipStart = alongOffset;
+        context.clipEnd = alongOffset + 2.0f * context.lineHalfWidth;
+        emitArc(context, points[0], points[1], alongOffset + context.lineHalfWidth, context.halfWidth, 0.0f, 2.0f * PI);
+        return;
+    }
+    int segments = closed ? count : count - 1;
+    if (count < 2 || (closed && count < 3)) {
+        return;
+    }
+
+    float length = 0.0f;
+    for (int i = 0; i < segments; i++) {
+        int j = (i + 1) % count;
+        length += std::hypot(points[j * 2] - points[i * 2], points[j * 2 + 1] - points[i * 2 + 1]);
+    }
+
+    float extension = (!closed && cap != CAP_BUTT) ? context.lineHalfWidth : 0.0f;
+    if (closed) {
+        context.clipStart = 0.0f;
+        context.clipEnd = 0.0f;
+    }
+    else {
+        context.clipStart = alongOffset;
+        context.clipEnd = alongOffset + length + 2.0f * extension;
+    }
+
+    float along = alongOffset + extension;
+    float firstDx = 0.0f, firstDy = 0.0f;
+    float previousDx = 0.0f, previousDy = 0.0f;
+    for (int i = 0; i < segments; i++) {
+        int j = (i + 1) % count;
+        float x0 = points[i * 2];
+        float y0 = points[i * 2 + 1];
+        float x1 = points[j * 2];
+        float y1 = points[j * 2 + 1];
+        float segmentLength = std::hypot(x1 - x0, y1 - y0);
+        float dx = (x1 - x0) / segmentLength;
+        float dy = (y1 - y0) / segmentLength;
+
+        if (i == 0) {
+            firstDx = dx;
+            firstDy = dy;
+        }
+        else {
+            emitJoin(context, x0, y0, along, previousDx, previousDy, dx, dy);
+        }
+
+        // прямые торцы продлеваются на полосу сглаживания, квадратные - еще на полуширину
+        float before = 0.0f;
+        float after = 0.0f;
+        if (!closed && cap != CAP_ROUND) {
+            before = i == 0 ? extension + context.fringe : 0.0f;
+            after = i == segments - 1 ? extension + context.fringe : 0.0f;
+        }
+        emitSegment(context, x0 - dx * before, y0 - dy * before, along - before,
+            x1 + dx * after, y1 + dy * after, along + segmentLength + after, -dy, dx);
+
+        along += segmentLength;
+        previousDx = dx;
+        previousDy = dy;
+    }
+
+    if (closed) {
+        emitJoin(context, points[0], points[1], along, previousDx, previousDy, firstDx, firstDy);
+    }
+    else if (cap == CAP_ROUND) {
+        float hw = context.halfWidth;
+        int last = count - 1;
+        emitArc(context, points[0], points[1], alongOffset + extension, -firstDy * hw, firstDx * hw, PI);
+        emitArc(context, points[last * 2], points[last * 2 + 1], along, previousDy * hw, -previousDx * hw, PI);
+    }
+}
+
+// временные массивы переиспользуются между вызовами
+static std::vector<float> cleanedPoints;
+static std::vector<float> dashPiece;
+
+static void appendPoint(std::vector<float>& points, float x, float y) {
+    size_t size = points.size();
+    if (size >= 2 && points[size - 2] == x && points[size - 1] == y) {
+        return;
+    }
+    points.push_back(x);
+    points.push_back(y);
+}
+
+// режет ломаную на штрихи по шаблону и обводит каждый отдельно
+static void strokeDashed(StrokeContext& context, const float* points, int count, bool closed,
+    const StrokeStyle& style) {
+    // нечетный шаблон повторяется дважды, чтобы штрихи и пробелы чередовались
+    int entries = style.dashCount % 2 ? style.dashCount * 2 : style.dashCount;
+    float period = 0.0f;
+    for (int i = 0; i < entries; i++) {
+        period += style.dashes[i % style.dashCount];
+    }
+    if (period <= 0.0f) {
+        strokeRun(context, points, count, closed, style.cap, 0.0f);
+        return;
+    }
+
+    int index = 0;
+    float offset = std::fmod(style.dashOffset, period);
+    offset = offset < 0.0f ? offset + period : offset;
+    while (offset > style.dashes[index % style.dashCount]) {
+        offset -= style.dashes[index % style.dashCount];
+        index = (index + 1) % entries;
+    }
+    float remaining = style.dashes[index % style.dashCount] - offset;
+
+    dashPiece.clear();
+    if (index % 2 == 0) {
+        appendPoint(dashPiece, points[0], points[1]);
+    }
+    int segments = closed ? count : count - 1;
+    for (int i = 0; i < segments; i++) {
+        int j = (i + 1) % count;
+        float x0 = points[i * 2];
+        float y0 = points[i * 2 + 1];
+        float dx = points[j * 2] - x0;
+        float dy = points[j * 2 + 1] - y0;
+        float segmentLength = std::hypot(dx, dy);
+
+        float position = 0.0f;
+        while (segmentLength - position > remaining) {
+            position += remaining;
+            float t = position / segmentLength;
+            if (index % 2 == 0) {
+                appendPoint(dashPiece, x0 + dx * t, y0 + dy * t);
+                strokeRun(context, dashPiece.data(), (int)(dashPiece.size() / 2), false, style.cap, 0.0f);
+                dashPiece.clear();
+            }
+            else {
+                appendPoint(dashPiece, x0 + dx * t, y0 + dy * t);
+            }
+            index = (index + 1) % entries;
+            remaining = style.dashes[index % style.dashCount];
+        }
+        remaining -= segmentLength - position;
+        if (index % 2 == 0) {
+            appendPoint(dashPiece, points[j * 2], points[j * 2 + 1]);
+        }
+    }
+    if (index % 2 == 0) {
+        strokeRun(context, dashPiece.data(), (int)(dashPiece.size() / 2), false, style.cap, 0.0f);
+    }
+}
+
+void strokePolyline(const float* points, int count, bool closed, const StrokeStyle& style,
+    float pixelsPerUnit, std::vector<StrokeVertex>& vertices) {
+    if (style.width <= 0.0f || pixelsPerUnit <= 0.0f) {
+        return;
+    }
+
+    cleanedPoints.clear();
+    for (int i = 0; i < count; i++) {
+        appendPoint(cleanedPoints, points[i * 2], points[i * 2 + 1]);
+    }
+    size_t size = cleanedPoints.size();
+    if (closed && size >= 4 && cleanedPoints[0] == cleanedPoints[size - 2] && cleanedPoints[1] == cleanedPoints[size - 1]) {
+        cleanedPoints.resize(size - 2);
+    }
+    int cleanedCount = (int)(cleanedPoints.size() / 2);
+    // без точек обводить нечего, а разбиение на штрихи читает первую точку
+    if (cleanedCount == 0) {
+        return;
+    }
+
+    StrokeContext context;
+    context.lineHalfWidth = 0.5f * style.width;
+    context.fringe = 1.0f / pixelsPerUnit;
+    context.halfWidth = context.lineHalfWidth + context.fringe;
+    context.edge = context.halfWidth / context.lineHalfWidth;
+    context.circleSegments = circleSegmentCount(context.halfWidth * pixelsPerUnit, 0.25f);
+    context.join = style.join;
+    context.miterLimit = style.miterLimit;
+    packStrokeColor(style.r, style.g, style.b, style.a, context.color);
+    context.vertices = &vertices;
+
+    if (style.dashCount == 0) {
+        strokeRun(context, cleanedPoints.data(), cleanedCount, closed, style.cap, 0.0f);
+    }
+    else if (style.dashCount == 2 && style.cap == CAP_BUTT) {
+        // одна пара штрих-пробел: вся линия одним куском, штрихи режет шейдер
+        context.dashOn = style.dashes[0];
+        context.dashPeriod = style.dashes[0] + style.dashes[1];
+        strokeRun(context, cleanedPoints.data(), cleanedCount, closed, style.cap, style.dashOffset);
+    }
+    else {
+        strokeDashed(context, cleanedPoints.data(), cleanedCount, closed, style);
+    }
+}
+
+void strokeContours(const std::vector<Contour>& contours, const StrokeStyle& style,
+    float pixelsPerUnit, std::vector<StrokeVertex>& vertices) {
+    for (const Contour& contour : contours) {
+        strokePolyline(contour.data(), (int)(contour.size() / 2), true, style, pixelsPerUnit, vertices);
+    }
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <vector>
+
+#include "Triangulator.h"
+
+// обводка ломаных: каждый отрезок - прямоугольник из двух треугольников,
+// на внешней стороне изломов добавляются треугольники соединения, на концах
+// открытых линий - торцы. Сглаживание и штриховка считаются во фрагментном
+// шейдере по координатам поперек и вдоль линии, поэтому CPU выдает только
+// контур обводки. Вершины совместимы с закраской StencilFiller: обводки
+// рисуются в тех же пакетах, что и заливки.
+
+enum LineJoin {
+    JOIN_MITER,  // острый угол, длиннее miterLimit полуширин - срез
+    JOIN_ROUND,
+    JOIN_BEVEL
+};
+
+enum LineCap {
+    CAP_BUTT,    // обрез ровно по концу линии
+    CAP_ROUND,
+    CAP_SQUARE   // продолжение на полуширину за конец
+};
+
+// штриховой шаблон: длины чередующихся штрихов и пробелов в единицах координат
+const int MAX_DASH_ENTRIES = 8;
+
+struct StrokeStyle {
+    float width = 0.01f;        // в единицах координат
+    LineJoin join = JOIN_MITER;
+    LineCap cap = CAP_BUTT;
+    float miterLimit = 4.0f;
+    float dashes[MAX_DASH_ENTRIES] = {};
+    int dashCount = 0;          // 0 - сплошная линия
+    float dashOffset = 0.0f;
+    float r = 1.0f;
+    float g = 1.0f;
+    float b = 1.0f;
+    float a = 1.0f;
+};
+
+// вершина обводки (36 байт). across - расстояние от средней линии в
+// полуширинах, 1 - край; along - путь вдоль линии со сдвигом шаблона.
+// Фрагменты вне [clipStart, clipEnd] по along гасятся, это сглаживает
+// торцы; clipEnd <= clipStart отключает проверку. dashPeriod 0 - без штрихов.
+// У закраски все поля, кроме позиции и цвета, нулевые
+struct StrokeVertex {
+    float x, y;
+    float across, along;
+    float dashOn, dashPeriod;
+    float clipStart, clipEnd;
+    unsigned char color[4];
+};
+
+// цвет 0..1 в байты вершины
+void packStrokeColor(float r, float g, float b, float a, unsigned char color[4]);
+
+// программа для вершин StrokeVertex и их формат в VAO (атрибуты 0-3, точка привязки 0)
+unsigned int createStrokeProgram();
+void setStrokeVertexFormat(unsigned int vao);
+
+// обводит ломаную из count точек (пары x, y). pixelsPerUnit нужен для полосы
+// сглаживания в один пиксель и числа сегментов скруглений. Шаблон из одной
+// пары штрих-пробел при CAP_BUTT штрихуется в шейдере, остальные шаблоны
+// режутся на куски на CPU, и каждый кусок получает торцы стиля; штрих
+// нулевой длины с CAP_ROUND дает точку.
+// Полупрозрачные обводки на внутренней стороне изломов перекрываются сами с собой
+void strokePolyline(const float* points, int count, bool closed, const StrokeStyle& style,
+    float pixelsPerUnit, std::vector<StrokeVertex>& vertices);
+
+// обводит все контуры как замкнутые ломаные
+void strokeContours(const std::vector<Contour>& contours, const StrokeStyle& style,
+    float pixelsPerUnit, std::vector<StrokeVertex>& vertices);
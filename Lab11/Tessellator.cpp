@@ -0,0 +1,164 @@
+﻿#include "Tessellator.h"
+#include <cmath>
+#include <unordered_map>
+
+#include "SimdTrig.h"
+
+static const double PI = 3.14159265358979323846;
+
+const TrigTable& trigTable(int segments) {
+    // узлы unordered_map не переезжают, поэтому ссылки на таблицы остаются валидными
+    static std::unordered_map<int, TrigTable> tables;
+
+    TrigTable& table = tables[segments];
+    if (table.segments == segments) {
+        return table;
+    }
+    table.segments = segments;
+    table.cosines.resize(segments + 1);
+    table.sines.resize(segments + 1);
+    for (int i = 0; i < segments; i++) {
+        double angle = 2.0 * PI * i / segments;
+        table.cosines[i] = (float)std::cos(angle);
+        table.sines[i] = (float)std::sin(angle);
+    }
+    table.cosines[segments] = table.cosines[0];
+    table.sines[segments] = table.sines[0];
+    return table;
+}
+
+int circleSegmentCount(float radius, float tolerance) {
+    if (radius <= tolerance) {
+        return 3;
+    }
+    // прогиб хорды: r * (1 - cos(pi / n)) <= tolerance
+    float step = 2.0f * std::acos(1.0f - tolerance / radius);
+    int segments = (int)std::ceil(2.0f * (float)PI / step);
+    return segments < 3 ? 3 : segments;
+}
+
+// веер из центра по точкам окружности; радиус точки i берется из radii[i % 2]
+static int writeFan(float* vertices, int segments, float centerX, float centerY, const float radii[2],
+    float rotationCos, float rotationSin) {
+    const TrigTable& table = trigTable(segments);
+    const float* cosines = table.cosines.data();
+    const float* sines = table.sines.data();
+
+    float previousX = centerX + radii[0] * rotationCos;
+    float previousY = centerY + radii[0] * rotationSin;
+    for (int i = 0; i < segments; i++) {
+        // поворот табличной точки на rotation: 4 умножения вместо cos/sin
+        float radius = radii[(i + 1) & 1];
+        float c = cosines[i + 1] * rotationCos - sines[i + 1] * rotationSin;
+        float s = sines[i + 1] * rotationCos + cosines[i + 1] * rotationSin;
+        float x = centerX + radius * c;
+        float y = centerY + radius * s;
+
+        vertices[i * 6] = centerX;
+        vertices[i * 6 + 1] = centerY;
+        vertices[i * 6 + 2] = previousX;
+        vertices[i * 6 + 3] = previousY;
+        vertices[i * 6 + 4] = x;
+        vertices[i * 6 + 5] = y;
+        previousX = x;
+        previousY = y;
+    }
+    return segments * 3;
+}
+
+int writeRegularPolygon(float* vertices, int sides, float centerX, float centerY, float radius, float rotation) {
+    const float radii[2] = { radius, radius };
+    return writeFan(vertices, sides, centerX, centerY, radii, std::cos(rotation), std::sin(rotation));
+}
+
+int writeRegularPolygons(float* vertices, const RegularPolygon* polygons, int count) {
+    // cos/sin поворотов считаются пакетами, по вызову ядра на 64 фигуры
+    const int batch = 64;
+    float angles[batch];
+    float sines[batch];
+    float cosines[batch];
+
+    int written = 0;
+    for (int first = 0; first < count; first += batch) {
+        int size = (count - first < batch) ? count - first : batch;
+        for (int i = 0; i < size; i++) {
+            angles[i] = polygons[first + i].rotation;
+        }
+        sincosBatch(angles, sines, cosines, size);
+
+        for (int i = 0; i < size; i++) {
+            const RegularPolygon& polygon = polygons[first + i];
+            const float radii[2] = { polygon.radius, polygon.radius };
+            written += writeFan(vertices + written * 2, polygon.sides, polygon.centerX, polygon.centerY, radii,
+                cosines[i], sines[i]);
+        }
+    }
+    return written;
+}
+
+int writeCircle(float* vertices, int segments, float centerX, float centerY, float radius) {
+    return writeRegularPolygon(vertices, segments, centerX, centerY, radius, 0.0f);
+}
+
+int writeArc(float* vertices, int segments, float centerX, float centerY, float radius, float startAngle, float sweep) {
+    // точки дуги считаются пакетами; соседние пакеты делят граничную точку
+    const int batch = 64;
+    float angles[batch + 1];
+    float sines[batch + 1];
+    float cosines[batch + 1];
+    float step = sweep / segments;
+
+    for (int first = 0; first < segments; first += batch) {
+        int size = (segments - first < batch) ? segments - first : batch;
+        for (int i = 0; i <= size; i++) {
+            angles[i] = startAngle + step * (first + i);
+        }
+        sincosBatch(angles, sines, cosines, size + 1);
+
+        for (int i = 0; i < size; i++) {
+            float* v = vertices + (first + i) * 6;
+            v[0] = centerX;
+            v[1] = centerY;
+            v[2] = centerX + radius * cosines[i];
+            v[3] = centerY + radius * sines[i];
+            v[4] = centerX + radius * cosines[i + 1];
+            v[5] = centerY + radius * sines[i + 1];
+        }
+    }
+    return segments * 3;
+}
+
+int writeRing(float* vertices, int segments, float centerX, float centerY, float innerRadius, float outerRadius, float rotation) {
+    const TrigTable& table = trigTable(segments);
+    float rotationCos = std::cos(rotation);
+    float rotationSin = std::sin(rotation);
+
+    for (int i = 0; i < segments; i++) {
+        float c0 = table.cosines[i] * rotationCos - table.sines[i] * rotationSin;
+        float s0 = table.sines[i] * rotationCos + table.cosines[i] * rotationSin;
+        float c1 = table.cosines[i + 1] * rotationCos - table.sines[i + 1] * rotationSin;
+        float s1 = table.sines[i + 1] * rotationCos + table.cosines[i + 1] * rotationSin;
+
+        float* v = vertices + i * 12;
+        // внутренняя 0, внешняя 0, внешняя 1
+        v[0] = centerX + innerRadius * c0;
+        v[1] = centerY + innerRadius * s0;
+        v[2] = centerX + outerRadius * c0;
+        v[3] = centerY + outerRadius * s0;
+        v[4] = centerX + outerRadius * c1;
+        v[5] = centerY + outerRadius * s1;
+        // внутренняя 0, внешняя 1, внутренняя 1
+        v[6] = v[0];
+        v[7] = v[1];
+        v[8] = v[4];
+        v[9] = v[5];
+        v[10] = centerX + innerRadius * c1;
+        v[11] = centerY + innerRadius * s1;
+    }
+    return segments * 6;
+}
+
+int writeStar(float* vertices, int points, float centerX, float centerY, float outerRadius, float innerRadius, float rotation) {
+    const float radii[2] = { outerRadius, innerRadius };
+    return writeFan(vertices, points * 2, centerX, centerY, radii, std::cos(rotation), std::sin(rotation));
+}
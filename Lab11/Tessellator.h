@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <vector>
+
+// генератор правильных фигур: все функции пишут массив треугольников
+// (пары x, y) в буфер вызывающего и возвращают число вершин.
+// Размер буфера заранее дают функции *VertexCount.
+
+// cos/sin для segments равных шагов по окружности; значений segments + 1,
+// последнее совпадает с первым, чтобы не брать индекс по модулю
+struct TrigTable {
+    int segments = 0;
+    std::vector<float> cosines;
+    std::vector<float> sines;
+};
+
+// таблица считается один раз на число сегментов и дальше берется из кэша
+const TrigTable& trigTable(int segments);
+
+// число сегментов окружности, при котором хорда отходит от дуги
+// не больше чем на tolerance (в тех же единицах, что и радиус)
+int circleSegmentCount(float radius, float tolerance);
+
+inline int polygonVertexCount(int sides) { return sides * 3; }
+inline int ringVertexCount(int segments) { return segments * 6; }
+inline int starVertexCount(int points) { return points * 2 * 3; }
+
+// веер из центра; первая вершина на окружности лежит под углом rotation
+int writeRegularPolygon(float* vertices, int sides, float centerX, float centerY, float radius, float rotation);
+
+// параметры одного многоугольника для пакетной генерации
+struct RegularPolygon {
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float radius = 0.0f;
+    float rotation = 0.0f;
+    int sides = 3;
+};
+
+// много многоугольников подряд в один буфер (размер - сумма polygonVertexCount);
+// cos/sin поворотов считаются векторным ядром sincosBatch
+int writeRegularPolygons(float* vertices, const RegularPolygon* polygons, int count);
+
+// круг: тот же веер с числом сегментов по допуску
+int writeCircle(float* vertices, int segments, float centerX, float centerY, float radius);
+
+// сектор от startAngle на sweep радиан; углы не кратны 2pi / n,
+// поэтому точки считаются пакетным sincosBatch, а не берутся из таблицы
+int writeArc(float* vertices, int segments, float centerX, float centerY, float radius, float startAngle, float sweep);
+
+// кольцо между innerRadius и outerRadius, по два треугольника на сегмент
+int writeRing(float* vertices, int segments, float centerX, float centerY, float innerRadius, float outerRadius, float rotation);
+
+// звезда с points лучами: вершины чередуются между outerRadius и innerRadius
+int writeStar(float* vertices, int points, float centerX, float centerY, float outerRadius, float innerRadius, float rotation);
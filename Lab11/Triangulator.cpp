@@ -0,0 +1,468 @@
+﻿#include "Triangulator.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+enum VertexType {
+    VERTEX_START,
+    VERTEX_END,
+    VERTEX_SPLIT,
+    VERTEX_MERGE,
+    VERTEX_REGULAR
+};
+
+// ребро i идет из вершины i в next[i]; внутренность многоугольника всегда слева
+struct Sweep {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<int> next;
+    std::vector<int> prev;
+    std::vector<int> rank;  // место вершины в порядке заметания (сверху вниз)
+    std::vector<VertexType> type;
+    int queryVertex = -1;
+};
+
+// > 0, если c слева от направленной прямой a -> b
+static double orient(const Sweep& sweep, int a, int b, int c) {
+    return (sweep.x[b] - sweep.x[a]) * (sweep.y[c] - sweep.y[a]) - (sweep.y[b] - sweep.y[a]) * (sweep.x[c] - sweep.x[a]);
+}
+
+// верхний и нижний концы ребра в порядке заметания
+static int upperEnd(const Sweep& sweep, int edge) {
+    int other = sweep.next[edge];
+    return sweep.rank[edge] < sweep.rank[other] ? edge : other;
+}
+
+static int lowerEnd(const Sweep& sweep, int edge) {
+    int other = sweep.next[edge];
+    return sweep.rank[edge] < sweep.rank[other] ? other : edge;
+}
+
+// > 0, если точка p правее ребра (восточнее); для ребра, направленного вниз,
+// это левая сторона, отсюда orient без смены знака
+static double sideOfEdge(const Sweep& sweep, int edge, int p) {
+    return orient(sweep, upperEnd(sweep, edge), lowerEnd(sweep, edge), p);
+}
+
+static const int QUERY_KEY = -1;
+
+// порядок ребер, пересекающих заметающую прямую, слева направо;
+// ключ QUERY_KEY обозначает точку sweep.queryVertex для поиска ребра слева от нее
+struct EdgeLess {
+    const Sweep* sweep;
+
+    bool operator()(int a, int b) const {
+        if (a == b) {
+            return false;
+        }
+        if (a == QUERY_KEY) {
+            return sideOfEdge(*sweep, b, sweep->queryVertex) < 0.0;
+        }
+        if (b == QUERY_KEY) {
+            return sideOfEdge(*sweep, a, sweep->queryVertex) > 0.0;
+        }
+        // ребра не пересекаются, поэтому достаточно сравнить верхний конец
+        // более позднего ребра с более ранним; на общей вершине берем нижний конец
+        int upperA = upperEnd(*sweep, a);
+        int upperB = upperEnd(*sweep, b);
+        if (sweep->rank[upperA] >= sweep->rank[upperB]) {
+            double side = sideOfEdge(*sweep, b, upperA);
+            if (side == 0.0) {
+                side = sideOfEdge(*sweep, b, lowerEnd(*sweep, a));
+            }
+            return side < 0.0;
+        }
+        double side = sideOfEdge(*sweep, a, upperB);
+        if (side == 0.0) {
+            side = sideOfEdge(*sweep, a, lowerEnd(*sweep, b));
+        }
+        return side > 0.0;
+    }
+};
+
+static double signedArea(const Contour& contour) {
+    size_t count = contour.size() / 2;
+    double area = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        size_t j = (i + 1) % count;
+        area += (double)contour[i * 2] * contour[j * 2 + 1] - (double)contour[j * 2] * contour[i * 2 + 1];
+    }
+    return area * 0.5;
+}
+
+// заметание сверху вниз; диагонали разбивают многоугольник на y-монотонные части
+static bool findMonotoneDiagonals(Sweep& sweep, const std::vector<int>& order, std::vector<std::pair<int, int>>& diagonals) {
+    int count = (int)order.size();
+    std::vector<int> helper(count, -1);
+    std::set<int, EdgeLess> status(EdgeLess{ &sweep });
+    std::vector<std::set<int, EdgeLess>::iterator> position(count, status.end());
+
+    // равное ребро в статусе бывает только при самопересечении или наложении ребер
+    auto insertEdge = [&](int edge, int v) {
+        auto inserted = status.insert(edge);
+        if (!inserted.second) {
+            return false;
+        }
+        position[edge] = inserted.first;
+        helper[edge] = v;
+        return true;
+    };
+    auto removeEdge = [&](int edge) {
+        if (position[edge] == status.end()) {
+            return false;
+        }
+        status.erase(position[edge]);
+        position[edge] = status.end();
+        return true;
+    };
+    auto connectMergeHelper = [&](int edge, int v) {
+        if (helper[edge] >= 0 && sweep.type[helper[edge]] == VERTEX_MERGE) {
+            diagonals.push_back(std::make_pair(v, helper[edge]));
+        }
+    };
+    // ребро непосредственно слева от вершины v
+    auto edgeLeftOf = [&](int v) {
+        sweep.queryVertex = v;
+        auto it = status.lower_bound(QUERY_KEY);
+        if (it == status.begin()) {
+            return -1;
+        }
+        return *--it;
+    };
+
+    for (int i = 0; i < count; i++) {
+        int v = order[i];
+        int previousEdge = sweep.prev[v];
+        switch (sweep.type[v]) {
+        case VERTEX_START:
+            if (!insertEdge(v, v)) {
+                return false;
+            }
+            break;
+        case VERTEX_END:
+            connectMergeHelper(previousEdge, v);
+            if (!removeEdge(previousEdge)) {
+                return false;
+            }
+            break;
+        case VERTEX_SPLIT: {
+            int left = edgeLeftOf(v);
+            if (left < 0) {
+                return false;
+            }
+            diagonals.push_back(std::make_pair(v, helper[left]));
+            helper[left] = v;
+            if (!insertEdge(v, v)) {
+                return false;
+            }
+            break;
+        }
+        case VERTEX_MERGE: {
+            connectMergeHelper(previousEdge, v);
+            if (!removeEdge(previousEdge)) {
+                return false;
+            }
+            int left = edgeLeftOf(v);
+            if (left < 0) {
+                return false;
+            }
+            connectMergeHelper(left, v);
+            helper[left] = v;
+            break;
+        }
+        case VERTEX_REGULAR:
+            // внутренность справа: вершина на левой цепи, граница идет вниз
+            if (sweep.rank[sweep.prev[v]] < sweep.rank[v]) {
+                connectMergeHelper(previousEdge, v);
+                if (!removeEdge(previousEdge) || !insertEdge(v, v)) {
+                    return false;
+                }
+            }
+            else {
+                int left = edgeLeftOf(v);
+                if (left < 0) {
+                    return false;
+                }
+                connectMergeHelper(left, v);
+                helper[left] = v;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+// обход граней графа "ребра + диагонали": каждая грань - монотонная часть
+static void collectMonotonePieces(const Sweep& sweep, const std::vector<std::pair<int, int>>& diagonals,
+    std::vector<int>& pieceVertices, std::vector<int>& pieceStarts) {
+    int count = (int)sweep.next.size();
+
+    // исходящие полуребра каждой вершины в формате CSR, отсортированные по углу
+    std::vector<int> degree(count + 1, 0);
+    for (int v = 0; v < count; v++) {
+        degree[v]++;
+    }
+    for (const auto& diagonal : diagonals) {
+        degree[diagonal.first]++;
+        degree[diagonal.second]++;
+    }
+    std::vector<int> first(count + 1, 0);
+    for (int v = 0; v < count; v++) {
+        first[v + 1] = first[v] + degree[v];
+    }
+    std::vector<int> target(first[count]);
+    std::vector<double> angle(first[count]);
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    auto addHalfEdge = [&](int from, int to) {
+        int slot = fill[from]++;
+        target[slot] = to;
+        angle[slot] = std::atan2(sweep.y[to] - sweep.y[from], sweep.x[to] - sweep.x[from]);
+    };
+    for (int v = 0; v < count; v++) {
+        addHalfEdge(v, sweep.next[v]);
+    }
+    for (const auto& diagonal : diagonals) {
+        addHalfEdge(diagonal.first, diagonal.second);
+        addHalfEdge(diagonal.second, diagonal.first);
+    }
+
+    std::vector<int> slots(first[count]);
+    for (int v = 0; v < count; v++) {
+        for (int s = first[v]; s < first[v + 1]; s++) {
+            slots[s] = s;
+        }
+        std::sort(slots.begin() + first[v], slots.begin() + first[v + 1],
+            [&](int a, int b) { return angle[a] < angle[b]; });
+    }
+
+    // из v, куда пришли из u, уходим по первому полуребру по часовой стрелке от v -> u
+    // (наибольший угол меньше угла v -> u, с переходом через -pi): грань остается слева
+    auto nextSlot = [&](int u, int v) {
+        double back = std::atan2(sweep.y[u] - sweep.y[v], sweep.x[u] - sweep.x[v]);
+        int chosen = slots[first[v + 1] - 1];
+        for (int s = first[v]; s < first[v + 1] && angle[slots[s]] < back; s++) {
+            chosen = slots[s];
+        }
+        return chosen;
+    };
+
+    std::vector<int> owner(first[count]);
+    for (int v = 0; v < count; v++) {
+        for (int s = first[v]; s < first[v + 1]; s++) {
+            owner[s] = v;
+        }
+    }
+    std::vector<bool> visited(first[count], false);
+    for (int start = 0; start < first[count]; start++) {
+        if (visited[start]) {
+            continue;
+        }
+        pieceStarts.push_back((int)pieceVertices.size());
+        int slot = start;
+        while (!visited[slot]) {
+            visited[slot] = true;
+            int from = owner[slot];
+            int to = target[slot];
+            pieceVertices.push_back(from);
+            slot = nextSlot(from, to);
+        }
+    }
+    pieceStarts.push_back((int)pieceVertices.size());
+}
+
+static void emitTriangle(const Sweep& sweep, std::vector<uint32_t>& indices, int a, int b, int c) {
+    if (orient(sweep, a, b, c) < 0.0) {
+        std::swap(b, c);
+    }
+    indices.push_back((uint32_t)a);
+    indices.push_back((uint32_t)b);
+    indices.push_back((uint32_t)c);
+}
+
+// стековая триангуляция одной y-монотонной части (вершины в порядке обхода против часовой)
+static void triangulateMonotone(const Sweep& sweep, const int* piece, int count, std::vector<uint32_t>& indices,
+    std::vector<int>& sorted, std::vector<bool>& onLeft, std::vector<int>& stack) {
+    if (count < 3) {
+        return;
+    }
+    if (count == 3) {
+        emitTriangle(sweep, indices, piece[0], piece[1], piece[2]);
+        return;
+    }
+
+    int top = 0;
+    int bottom = 0;
+    for (int i = 1; i < count; i++) {
+        if (sweep.rank[piece[i]] < sweep.rank[piece[top]]) {
+            top = i;
+        }
+        if (sweep.rank[piece[i]] > sweep.rank[piece[bottom]]) {
+            bottom = i;
+        }
+    }
+
+    // от верхней вершины против часовой стрелки идет левая цепь (до нижней включительно),
+    // в обратную сторону - правая; обе уже упорядочены сверху вниз, их достаточно слить
+    int leftCount = (bottom - top + count) % count;
+    int rightCount = count - 1 - leftCount;
+    int left = (top + 1) % count;
+    int right = (top + count - 1) % count;
+    sorted.clear();
+    onLeft.clear();
+    sorted.push_back(piece[top]);
+    onLeft.push_back(true);
+    while (leftCount > 0 || rightCount > 0) {
+        bool takeLeft = rightCount == 0 || (leftCount > 0 && sweep.rank[piece[left]] < sweep.rank[piece[right]]);
+        if (takeLeft) {
+            sorted.push_back(piece[left]);
+            onLeft.push_back(true);
+            left = (left + 1) % count;
+            leftCount--;
+        }
+        else {
+            sorted.push_back(piece[right]);
+            onLeft.push_back(false);
+            right = (right + count - 1) % count;
+            rightCount--;
+        }
+    }
+
+    std::vector<int>& chain = stack;
+    chain.clear();
+    chain.push_back(0);
+    chain.push_back(1);
+    for (int j = 2; j < count - 1; j++) {
+        int u = sorted[j];
+        if (onLeft[j] != onLeft[chain.back()]) {
+            // другая цепь: видны все вершины стека
+            for (size_t k = 1; k < chain.size(); k++) {
+                emitTriangle(sweep, indices, u, sorted[chain[k - 1]], sorted[chain[k]]);
+            }
+            int previous = chain.back();
+            chain.clear();
+            chain.push_back(previous);
+            chain.push_back(j);
+        }
+        else {
+            // та же цепь: снимаем вершины, пока диагональ к ним проходит внутри
+            int last = chain.back();
+            chain.pop_back();
+            while (!chain.empty()) {
+                double turn = orient(sweep, u, sorted[last], sorted[chain.back()]);
+                bool inside = onLeft[j] ? turn < 0.0 : turn > 0.0;
+                if (!inside) {
+                    break;
+                }
+                emitTriangle(sweep, indices, u, sorted[last], sorted[chain.back()]);
+                last = chain.back();
+                chain.pop_back();
+            }
+            chain.push_back(last);
+            chain.push_back(j);
+        }
+    }
+
+    int u = sorted[count - 1];
+    for (size_t k = 1; k < chain.size(); k++) {
+        emitTriangle(sweep, indices, u, sorted[chain[k - 1]], sorted[chain[k]]);
+    }
+}
+
+bool triangulatePolygon(const std::vector<Contour>& contours, IndexedMesh& mesh) {
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    if (contours.empty()) {
+        return false;
+    }
+
+    // внешний контур против часовой стрелки, дыры по часовой: внутренность слева от каждого ребра
+    Sweep sweep;
+    for (size_t c = 0; c < contours.size(); c++) {
+        const Contour& contour = contours[c];
+        int points = (int)(contour.size() / 2);
+        if (points < 3) {
+            return false;
+        }
+        bool reverse = (signedArea(contour) > 0.0) != (c == 0);
+        int base = (int)sweep.x.size();
+        for (int i = 0; i < points; i++) {
+            int source = reverse ? points - 1 - i : i;
+            sweep.x.push_back(contour[source * 2]);
+            sweep.y.push_back(contour[source * 2 + 1]);
+            mesh.vertices.push_back(contour[source * 2]);
+            mesh.vertices.push_back(contour[source * 2 + 1]);
+            sweep.next.push_back(base + (i + 1) % points);
+            sweep.prev.push_back(base + (i + points - 1) % points);
+        }
+    }
+
+    int count = (int)sweep.x.size();
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    // сверху вниз, при равной y - слева направо
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (sweep.y[a] != sweep.y[b]) {
+            return sweep.y[a] > sweep.y[b];
+        }
+        if (sweep.x[a] != sweep.x[b]) {
+            return sweep.x[a] < sweep.x[b];
+        }
+        return a < b;
+    });
+    sweep.rank.resize(count);
+    for (int i = 0; i < count; i++) {
+        sweep.rank[order[i]] = i;
+    }
+
+    sweep.type.resize(count);
+    for (int v = 0; v < count; v++) {
+        int p = sweep.prev[v];
+        int n = sweep.next[v];
+        bool prevBelow = sweep.rank[p] > sweep.rank[v];
+        bool nextBelow = sweep.rank[n] > sweep.rank[v];
+        bool convex = orient(sweep, p, v, n) > 0.0;
+        if (prevBelow && nextBelow) {
+            sweep.type[v] = convex ? VERTEX_START : VERTEX_SPLIT;
+        }
+        else if (!prevBelow && !nextBelow) {
+            sweep.type[v] = convex ? VERTEX_END : VERTEX_MERGE;
+        }
+        else {
+            sweep.type[v] = VERTEX_REGULAR;
+        }
+    }
+
+    std::vector<std::pair<int, int>> diagonals;
+    if (!findMonotoneDiagonals(sweep, order, diagonals)) {
+        mesh.vertices.clear();
+        return false;
+    }
+    // одна и та же диагональ может появиться дважды, а совпадающая с ребром не нужна
+    for (auto& diagonal : diagonals) {
+        if (diagonal.first > diagonal.second) {
+            std::swap(diagonal.first, diagonal.second);
+        }
+    }
+    std::sort(diagonals.begin(), diagonals.end());
+    diagonals.erase(std::unique(diagonals.begin(), diagonals.end()), diagonals.end());
+    diagonals.erase(std::remove_if(diagonals.begin(), diagonals.end(), [&](const std::pair<int, int>& d) {
+        return d.first == d.second || sweep.next[d.first] == d.second || sweep.next[d.second] == d.first;
+    }), diagonals.end());
+
+    std::vector<int> pieceVertices;
+    std::vector<int> pieceStarts;
+    collectMonotonePieces(sweep, diagonals, pieceVertices, pieceStarts);
+
+    mesh.indices.reserve((count + 2 * contours.size()) * 3);
+    std::vector<int> sorted;
+    std::vector<bool> onLeft;
+    std::vector<int> stack;
+    for (size_t p = 0; p + 1 < pieceStarts.size(); p++) {
+        triangulateMonotone(sweep, pieceVertices.data() + pieceStarts[p], pieceStarts[p + 1] - pieceStarts[p],
+            mesh.indices, sorted, onLeft, stack);
+    }
+    return true;
+}
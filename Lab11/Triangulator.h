@@ -0,0 +1,17 @@
+﻿#pragma once
+#include <vector>
+
+#include "IndexedMesh.h"
+
+// триангуляция простого многоугольника с дырами за O(n log n):
+// разбиение на y-монотонные части заметающей прямой, затем каждая часть
+// триангулируется стеком (де Берг и др., "Вычислительная геометрия", гл. 3)
+
+// замкнутый контур: пары x, y без повтора первой точки в конце
+typedef std::vector<float> Contour;
+
+// contours[0] - внешняя граница, остальные - дыры внутри нее; ориентация
+// контуров может быть любой. Вершины сетки - все контуры подряд, треугольники
+// против часовой стрелки. Возвращает false, если контур вырожден или
+// заметание наткнулось на самопересечение
+bool triangulatePolygon(const std::vector<Contour>& contours, IndexedMesh& mesh);
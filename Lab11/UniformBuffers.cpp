@@ -0,0 +1,142 @@
+﻿#include "UniformBuffers.h"
+#include <GL/glew.h>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "GLState.h"
+#include "ShaderPipeline.h"
+
+struct BlockBinding {
+    const char* name;
+    UniformBinding binding;
+};
+
+static const BlockBinding blockBindings[] = {
+    { "FrameConstants", UNIFORM_FRAME_CONSTANTS },
+    { "DrawConstants", UNIFORM_DRAW_CONSTANTS }
+};
+
+// std::less<> позволяет искать по const char* без временной std::string
+typedef std::map<std::string, int, std::less<>> UniformLocations;
+static std::map<unsigned int, UniformLocations> programLocations;
+
+void resolveProgramUniforms(unsigned int program) {
+    // у незаконченной программы активных uniform еще нет, пустой список не запоминается
+    if (isShaderProgramLinking(program)) {
+        return;
+    }
+    UniformLocations& locations = programLocations[program];
+    locations.clear();
+
+    int count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; i++) {
+        char name[256];
+        int length = 0;
+        int size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(program, (unsigned int)i, sizeof(name), &length, &size, &type, name);
+        int location = glGetUniformLocation(program, name);
+        // члены блоков положения не имеют
+        if (location < 0) {
+            continue;
+        }
+        std::string uniform(name, length);
+        locations[uniform] = location;
+        // массив доступен и по имени без "[0]"
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+            locations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+    }
+
+    for (const BlockBinding& block : blockBindings) {
+        unsigned int index = glGetUniformBlockIndex(program, block.name);
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, index, block.binding);
+        }
+    }
+}
+
+void forgetProgramUniforms(unsigned int program) {
+    programLocations.erase(program);
+}
+
+int uniformLocation(unsigned int program, const char* name) {
+    prepareShaderProgram(program);
+    auto found = programLocations.find(program);
+    if (found == programLocations.end()) {
+        resolveProgramUniforms(program);
+        found = programLocations.find(program);
+        if (found == programLocations.end()) {
+            return -1;
+        }
+    }
+    auto location = found->second.find(name);
+    return location == found->second.end() ? -1 : location->second;
+}
+
+bool createUniformRing(UniformRing& ring, size_t frameCapacity, UploadMethod method) {
+    int alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    ring.alignment = alignment > 0 ? (size_t)alignment : 256;
+    ring.stream = createUploadStrategy(method);
+    if (!ring.stream->create(GL_UNIFORM_BUFFER, frameCapacity)) {
+        delete ring.stream;
+        ring.stream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void destroyUniformRing(UniformRing& ring) {
+    if (ring.stream == nullptr) {
+        return;
+    }
+    ring.stream->destroy();
+    delete ring.stream;
+    ring.stream = nullptr;
+}
+
+void beginUniformFrame(UniformRing& ring) {
+    ring.stream->beginFrame();
+    ring.frameBytes = 0;
+    ring.frameUploads = 0;
+}
+
+void endUniformFrame(UniformRing& ring) {
+    ring.stream->endFrame();
+}
+
+void* allocateUniformBlocks(UniformRing& ring, size_t blockSize, int count, size_t& firstOffset, size_t& stride) {
+    stride = (blockSize + ring.alignment - 1) / ring.alignment * ring.alignment;
+    size_t bytes = stride * (count - 1) + blockSize;
+    void* memory = ring.stream->allocate(bytes, ring.alignment, firstOffset);
+    if (memory != nullptr) {
+        ring.frameBytes += bytes;
+    }
+    return memory;
+}
+
+void commitUniformBlocks(UniformRing& ring) {
+    ring.stream->commit();
+    ring.frameUploads++;
+}
+
+void bindUniformBlock(UniformRing& ring, UniformBinding binding, size_t offset, size_t size) {
+    stateBindBufferRange(GL_UNIFORM_BUFFER, binding, ring.stream->buffer(), offset, size);
+}
+
+bool uploadUniformBlock(UniformRing& ring, UniformBinding binding, const void* data, size_t size) {
+    size_t offset;
+    size_t stride;
+    void* memory = allocateUniformBlocks(ring, size, 1, offset, stride);
+    if (memory == nullptr) {
+        return false;
+    }
+    memcpy(memory, data, size);
+    commitUniformBlocks(ring);
+    bindUniformBlock(ring, binding, offset, size);
+    return true;
+}
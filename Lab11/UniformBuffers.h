@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <cstddef>
+
+#include "UploadStrategy.h"
+
+// данные шейдеров без отдельных glUniform*: положения обычных uniform
+// запоминаются один раз после сборки программы, а константы кадра и вызова
+// лежат в std140-блоках с постоянными точками привязки
+
+enum UniformBinding {
+    UNIFORM_FRAME_CONSTANTS = 0,  // блок FrameConstants
+    UNIFORM_DRAW_CONSTANTS = 1    // блок DrawConstants
+};
+
+// раскладка std140 должна совпадать с объявлениями блоков в шейдерах
+struct FrameConstants {
+    float viewport[4];  // ширина, высота, 1/ширина, 1/высота
+    float time;
+    float padding[3];
+};
+
+struct DrawConstants {
+    float color[4];
+    float transform[4];  // сдвиг x, y, масштаб, поворот
+};
+
+static_assert(sizeof(FrameConstants) == 32, "FrameConstants must match std140 layout");
+static_assert(sizeof(DrawConstants) == 32, "DrawConstants must match std140 layout");
+
+// запоминает положения активных uniform и привязывает известные блоки к их
+// точкам; вызывается, когда сборка программы закончена (ShaderPipeline.h).
+// Для программы, которая еще собирается, ничего не запоминает
+void resolveProgramUniforms(unsigned int program);
+void forgetProgramUniforms(unsigned int program);
+
+// положение из кэша, -1 если такого uniform нет; для программы, которая еще
+// не собрана, ждет конца сборки, как и glGetUniformLocation
+int uniformLocation(unsigned int program, const char* name);
+
+// кольцо uniform-буфера: за кадр данные пишутся одной или несколькими
+// большими порциями, а каждый вызов видит свой участок через glBindBufferRange
+struct UniformRing {
+    UploadStrategy* stream = nullptr;
+    size_t alignment = 256;  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t frameBytes = 0;   // записано за кадр
+    int frameUploads = 0;    // число commit за кадр
+};
+
+bool createUniformRing(UniformRing& ring, size_t frameCapacity, UploadMethod method);
+void destroyUniformRing(UniformRing& ring);
+
+void beginUniformFrame(UniformRing& ring);
+void endUniformFrame(UniformRing& ring);
+
+// место под count блоков по blockSize байт; stride - шаг между блоками,
+// кратный выравниванию смещений. nullptr, если кольцо переполнено
+void* allocateUniformBlocks(UniformRing& ring, size_t blockSize, int count, size_t& firstOffset, size_t& stride);
+void commitUniformBlocks(UniformRing& ring);
+
+// привязывает блок по смещению offset к точке binding
+void bindUniformBlock(UniformRing& ring, UniformBinding binding, size_t offset, size_t size);
+
+// копирует один блок в кольцо и сразу привязывает его
+bool uploadUniformBlock(UniformRing& ring, UniformBinding binding, const void* data, size_t size);
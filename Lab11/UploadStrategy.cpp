@@ -0,0 +1,360 @@
+﻿#include "UploadStrategy.h"
+#include <GL/glew.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "GLState.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// общая часть стратегий, пишущих через промежуточный буфер на CPU
+class StagedUploadStrategy : public UploadStrategy {
+protected:
+    unsigned int bufferObject = 0;
+    size_t capacity = 0;
+    size_t head = 0;
+    std::vector<unsigned char> staging;
+    size_t pendingOffset = 0;
+    size_t pendingSize = 0;
+
+    // смещение начала записи с учетом кольца; ~0 - нет места
+    virtual size_t place(size_t bytes, size_t alignment) = 0;
+
+public:
+    unsigned int buffer() const override {
+        return bufferObject;
+    }
+
+    void destroy() override {
+        gpuBackend().deleteBuffer(bufferObject);
+        bufferObject = 0;
+    }
+
+    void* allocate(size_t bytes, size_t alignment, size_t& offset) override {
+        commit();
+        offset = place(bytes, alignment);
+        if (offset == (size_t)-1) {
+            std::cout << uploadMethodName(method()) << " upload: out of space (" << bytes << " bytes requested)" << std::endl;
+            return nullptr;
+        }
+        if (staging.size() < bytes) {
+            staging.resize(bytes);
+        }
+        pendingOffset = offset;
+        pendingSize = bytes;
+        return staging.data();
+    }
+
+    void commit() override {
+        if (pendingSize == 0) {
+            return;
+        }
+        gpuBackend().bufferSubData(bufferObject, pendingOffset, pendingSize, staging.data());
+        pendingSize = 0;
+    }
+};
+
+// переразмещение: в начале кадра драйвер выдает новое хранилище,
+// старое остается у GPU, пока тот его читает
+class OrphanUploadStrategy : public StagedUploadStrategy {
+protected:
+    size_t place(size_t bytes, size_t alignment) override {
+        size_t offset = alignUp(head, alignment);
+        if (offset + bytes > capacity) {
+            return (size_t)-1;
+        }
+        head = offset + bytes;
+        return offset;
+    }
+
+public:
+    UploadMethod method() const override {
+        return UPLOAD_ORPHAN;
+    }
+
+    bool create(unsigned int, size_t frameCapacity) override {
+        capacity = frameCapacity;
+        bufferObject = gpuBackend().createBuffer(capacity, nullptr, BUFFER_STREAM);
+        return bufferObject != 0;
+    }
+
+    void beginFrame() override {
+        head = 0;
+        stateBindBuffer(GL_COPY_WRITE_BUFFER, bufferObject);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    }
+
+    void endFrame() override {
+        commit();
+    }
+};
+
+// кольцо на несколько кадров; синхронизацию с GPU выполняет драйвер внутри glBufferSubData
+class SubDataUploadStrategy : public StagedUploadStrategy {
+protected:
+    size_t place(size_t bytes, size_t alignment) override {
+        size_t offset = alignUp(head, alignment);
+        if (offset + bytes > capacity) {
+            offset = 0;
+            if (bytes > capacity) {
+                return (size_t)-1;
+            }
+        }
+        head = offset + bytes;
+        return offset;
+    }
+
+public:
+    UploadMethod method() const override {
+        return UPLOAD_SUBDATA;
+    }
+
+    bool create(unsigned int, size_t frameCapacity) override {
+        capacity = frameCapacity * STREAM_FRAMES_IN_FLIGHT;
+        bufferObject = gpuBackend().createBuffer(capacity, nullptr, BUFFER_DYNAMIC);
+        return bufferObject != 0;
+    }
+
+    void beginFrame() override {
+    }
+
+    void endFrame() override {
+        commit();
+    }
+};
+
+// обе стратегии с отображением работают поверх кольцевого буфера с fence
+class MappedUploadStrategy : public UploadStrategy {
+    StreamBuffer stream;
+    bool persistent;
+
+public:
+    explicit MappedUploadStrategy(bool persistent) : persistent(persistent) {}
+
+    UploadMethod method() const override {
+        return persistent ? UPLOAD_PERSISTENT : UPLOAD_MAP_UNSYNCHRONIZED;
+    }
+
+    bool create(unsigned int target, size_t frameCapacity) override {
+        return createStreamBuffer(stream, target, frameCapacity, persistent);
+    }
+
+    void destroy() override {
+        destroyStreamBuffer(stream);
+    }
+
+    unsigned int buffer() const override {
+        return stream.buffer;
+    }
+
+    void beginFrame() override {
+        beginStreamFrame(stream);
+    }
+
+    void endFrame() override {
+        streamCommit(stream);
+        endStreamFrame(stream);
+    }
+
+    void* allocate(size_t bytes, size_t alignment, size_t& offset) override {
+        return streamAllocate(stream, bytes, alignment, offset);
+    }
+
+    void commit() override {
+        streamCommit(stream);
+    }
+};
+
+const char* uploadMethodName(UploadMethod method) {
+    switch (method) {
+    case UPLOAD_ORPHAN:
+        return "orphan";
+    case UPLOAD_SUBDATA:
+        return "subdata";
+    case UPLOAD_MAP_UNSYNCHRONIZED:
+        return "map-unsynchronized";
+    case UPLOAD_PERSISTENT:
+        return "persistent";
+    default:
+        return "unknown";
+    }
+}
+
+bool parseUploadMethod(const std::string& name, UploadMethod& method) {
+    for (int i = 0; i < UPLOAD_METHOD_COUNT; i++) {
+        if (name == uploadMethodName((UploadMethod)i)) {
+            method = (UploadMethod)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isUploadMethodSupported(UploadMethod method) {
+    return method != UPLOAD_PERSISTENT || GLEW_ARB_buffer_storage;
+}
+
+UploadStrategy* createUploadStrategy(UploadMethod method) {
+    switch (method) {
+    case UPLOAD_ORPHAN:
+        return new OrphanUploadStrategy();
+    case UPLOAD_SUBDATA:
+        return new SubDataUploadStrategy();
+    case UPLOAD_MAP_UNSYNCHRONIZED:
+        return new MappedUploadStrategy(false);
+    default:
+        return new MappedUploadStrategy(true);
+    }
+}
+
+bool parseUploadArgument(const std::string& argument, UploadConfig& config) {
+    const std::string dynamicPrefix = "--upload-dynamic=";
+    const std::string streamPrefix = "--upload-stream=";
+    UploadMethod method;
+
+    if (argument.compare(0, dynamicPrefix.size(), dynamicPrefix) == 0) {
+        if (parseUploadMethod(argument.substr(dynamicPrefix.size()), method)) {
+            config.dynamicMethod = method;
+            config.dynamicOverridden = true;
+        }
+        else {
+            std::cout << "Unknown upload method: " << argument << std::endl;
+        }
+        return true;
+    }
+    if (argument.compare(0, streamPrefix.size(), streamPrefix) == 0) {
+        if (parseUploadMethod(argument.substr(streamPrefix.size()), method)) {
+            config.streamMethod = method;
+            config.streamOverridden = true;
+        }
+        else {
+            std::cout << "Unknown upload method: " << argument << std::endl;
+        }
+        return true;
+    }
+    return false;
+}
+
+// нагрузка замера: много мелких порций для BUFFER_DYNAMIC,
+// одна крупная (как 100 тысяч экземпляров) для BUFFER_STREAM
+static void uploadWorkload(BufferKind usage, int& chunks, size_t& chunkBytes) {
+    if (usage == BUFFER_STREAM) {
+        chunks = 1;
+        chunkBytes = 100000 * 32;
+    }
+    else {
+        chunks = 64;
+        chunkBytes = 2048;
+    }
+}
+
+static const char* uploadBenchmarkVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    void main() {
+        gl_Position = vec4(aPos, 0.0, 1.0);
+    }
+)";
+
+static const char* uploadBenchmarkFragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(1.0);
+    }
+)";
+
+double measureUploadMethod(UploadMethod method, BufferKind usage, int frames) {
+    if (!isUploadMethodSupported(method)) {
+        return -1.0;
+    }
+    int chunks;
+    size_t chunkBytes;
+    uploadWorkload(usage, chunks, chunkBytes);
+
+    UploadStrategy* strategy = createUploadStrategy(method);
+    if (!strategy->create(GL_ARRAY_BUFFER, chunks * chunkBytes)) {
+        delete strategy;
+        return -1.0;
+    }
+
+    // каждая порция сразу читается рисованием, чтобы синхронизация с GPU входила в замер
+    unsigned int program = createShaderProgram(uploadBenchmarkVertexShaderSource, uploadBenchmarkFragmentShaderSource);
+    GpuBackend& backend = gpuBackend();
+    unsigned int vao = backend.createVertexArray();
+    backend.setVertexAttribute(vao, 0, 0, 2, GL_FLOAT, false, 0);
+    backend.setVertexBuffer(vao, 0, strategy->buffer(), 0, 2 * sizeof(float));
+    stateUseProgram(program);
+    stateBindVertexArray(vao);
+
+    const size_t stride = 2 * sizeof(float);
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        strategy->beginFrame();
+        for (int i = 0; i < chunks; i++) {
+            size_t offset;
+            unsigned char* memory = (unsigned char*)strategy->allocate(chunkBytes, stride, offset);
+            if (!memory) {
+                break;
+            }
+            for (size_t j = 0; j < chunkBytes; j += 64) {
+                memory[j] = (unsigned char)(frame + i);
+            }
+            strategy->commit();
+            glDrawArrays(GL_POINTS, (GLint)(offset / stride), 1);
+        }
+        strategy->endFrame();
+        glFlush();
+    }
+    glFinish();
+    double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    backend.deleteVertexArray(vao);
+    strategy->destroy();
+    delete strategy;
+    stateForgetProgram(program);
+    deleteShaderProgram(program);
+    return total / frames;
+}
+
+static UploadMethod fastestUploadMethod(BufferKind usage, int frames) {
+    UploadMethod best = UPLOAD_SUBDATA;
+    double bestTime = -1.0;
+    for (int i = 0; i < UPLOAD_METHOD_COUNT; i++) {
+        double time = measureUploadMethod((UploadMethod)i, usage, frames);
+        if (time >= 0.0 && (bestTime < 0.0 || time < bestTime)) {
+            bestTime = time;
+            best = (UploadMethod)i;
+        }
+    }
+    return best;
+}
+
+void selectUploadMethods(UploadConfig& config, bool measure) {
+    UploadMethod fallback = GLEW_ARB_buffer_storage ? UPLOAD_PERSISTENT : UPLOAD_MAP_UNSYNCHRONIZED;
+    const int frames = 30;
+
+    if (!config.dynamicOverridden) {
+        config.dynamicMethod = measure ? fastestUploadMethod(BUFFER_DYNAMIC, frames) : fallback;
+    }
+    if (!config.streamOverridden) {
+        config.streamMethod = measure ? fastestUploadMethod(BUFFER_STREAM, frames) : fallback;
+    }
+    // явно заданный, но неподдерживаемый способ заменяется запасным
+    if (!isUploadMethodSupported(config.dynamicMethod)) {
+        config.dynamicMethod = UPLOAD_MAP_UNSYNCHRONIZED;
+    }
+    if (!isUploadMethodSupported(config.streamMethod)) {
+        config.streamMethod = UPLOAD_MAP_UNSYNCHRONIZED;
+    }
+}
+
+UploadMethod uploadMethodFor(const UploadConfig& config, BufferKind usage) {
+    return usage == BUFFER_STREAM ? config.streamMethod : config.dynamicMethod;
+}
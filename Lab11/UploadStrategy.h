@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+
+#include "GpuBackend.h"
+
+// способы передачи данных, которые меняются каждый кадр
+enum UploadMethod {
+    UPLOAD_ORPHAN,              // glBufferData(nullptr) в начале кадра + glBufferSubData
+    UPLOAD_SUBDATA,             // glBufferSubData в кольцо без явной синхронизации
+    UPLOAD_MAP_UNSYNCHRONIZED,  // glMapBufferRange с UNSYNCHRONIZED | INVALIDATE_RANGE и fence
+    UPLOAD_PERSISTENT,          // постоянное отображение ARB_buffer_storage и fence
+    UPLOAD_METHOD_COUNT
+};
+
+// единый интерфейс загрузки: allocate дает указатель, куда писать данные
+// (отображенная память или промежуточный буфер на CPU), commit отправляет
+// записанное в буфер до рисования. offset - смещение данных в buffer().
+class UploadStrategy {
+public:
+    virtual ~UploadStrategy() {}
+    virtual UploadMethod method() const = 0;
+    virtual bool create(unsigned int target, size_t frameCapacity) = 0;
+    virtual void destroy() = 0;
+    virtual unsigned int buffer() const = 0;
+    virtual void beginFrame() = 0;
+    virtual void endFrame() = 0;
+    virtual void* allocate(size_t bytes, size_t alignment, size_t& offset) = 0;
+    virtual void commit() = 0;
+};
+
+const char* uploadMethodName(UploadMethod method);
+bool parseUploadMethod(const std::string& name, UploadMethod& method);
+bool isUploadMethodSupported(UploadMethod method);
+
+// создает стратегию; удаляется через delete после destroy()
+UploadStrategy* createUploadStrategy(UploadMethod method);
+
+// выбор способа для классов использования BUFFER_DYNAMIC и BUFFER_STREAM
+// (статические данные кладутся в арену один раз и всегда идут через bufferSubData)
+struct UploadConfig {
+    UploadMethod dynamicMethod = UPLOAD_PERSISTENT;
+    UploadMethod streamMethod = UPLOAD_PERSISTENT;
+    bool dynamicOverridden = false;
+    bool streamOverridden = false;
+};
+
+// разбирает --upload-dynamic=<способ> и --upload-stream=<способ>; false - если аргумент не относится к загрузке
+bool parseUploadArgument(const std::string& argument, UploadConfig& config);
+
+// способы по умолчанию для текущего контекста; при measure = true
+// незаданные явно классы выбираются коротким замером при запуске
+void selectUploadMethods(UploadConfig& config, bool measure);
+
+UploadMethod uploadMethodFor(const UploadConfig& config, BufferKind usage);
+
+// среднее время кадра (мс) для способа и класса использования
+double measureUploadMethod(UploadMethod method, BufferKind usage, int frames);
@@ -0,0 +1,216 @@
+﻿#include "VectorPath.h"
+#include <cmath>
+
+void clearPath(VectorPath& path) {
+    path.verbs.clear();
+    path.points.clear();
+}
+
+void pathMoveTo(VectorPath& path, float x, float y) {
+    path.verbs.push_back(PATH_MOVE);
+    path.points.push_back(x);
+    path.points.push_back(y);
+}
+
+void pathLineTo(VectorPath& path, float x, float y) {
+    path.verbs.push_back(PATH_LINE);
+    path.points.push_back(x);
+    path.points.push_back(y);
+}
+
+void pathQuadTo(VectorPath& path, float controlX, float controlY, float x, float y) {
+    path.verbs.push_back(PATH_QUAD);
+    const float points[4] = { controlX, controlY, x, y };
+    path.points.insert(path.points.end(), points, points + 4);
+}
+
+void pathCubicTo(VectorPath& path, float control1X, float control1Y, float control2X, float control2Y, float x, float y) {
+    path.verbs.push_back(PATH_CUBIC);
+    const float points[6] = { control1X, control1Y, control2X, control2Y, x, y };
+    path.points.insert(path.points.end(), points, points + 6);
+}
+
+void pathClose(VectorPath& path) {
+    path.verbs.push_back(PATH_CLOSE);
+}
+
+// приближенный интеграл sqrt(1 + 4x^2) и обратная к нему функция
+static float parabolaIntegral(float x) {
+    const float d = 0.67f;
+    return x / (1.0f - d + std::sqrt(std::sqrt(d * d * d * d + 0.25f * x * x)));
+}
+
+static float parabolaInverseIntegral(float x) {
+    const float b = 0.39f;
+    return x * (1.0f - b + std::sqrt(b * b + 0.25f * x * x));
+}
+
+// добавляет точки квадратичной кривой p0 - p1 - p2 без начальной p0
+static void flattenQuad(float x0, float y0, float x1, float y1, float x2, float y2, float sqrtTolerance, Contour& contour) {
+    // кривая как участок параболы y = x^2 от x0 до x2 в ее собственных координатах
+    float d01x = x1 - x0;
+    float d01y = y1 - y0;
+    float d12x = x2 - x1;
+    float d12y = y2 - y1;
+    float ddx = d01x - d12x;
+    float ddy = d01y - d12y;
+    float cross = (x2 - x0) * ddy - (y2 - y0) * ddx;
+    float parabolaX0 = (d01x * ddx + d01y * ddy) / cross;
+    float parabolaX2 = (d12x * ddx + d12y * ddy) / cross;
+    float scale = std::fabs(cross / (std::sqrt(ddx * ddx + ddy * ddy) * (parabolaX2 - parabolaX0)));
+
+    float a0 = parabolaIntegral(parabolaX0);
+    float a2 = parabolaIntegral(parabolaX2);
+    float value = 0.0f;
+    // прямая или вырожденная кривая дает бесконечный масштаб: хватает одного отрезка
+    if (std::isfinite(scale)) {
+        float da = std::fabs(a2 - a0);
+        float sqrtScale = std::sqrt(scale);
+        if ((parabolaX0 < 0.0f) == (parabolaX2 < 0.0f)) {
+            value = da * sqrtScale;
+        }
+        else {
+            // участок проходит через вершину параболы
+            float xMin = sqrtTolerance / sqrtScale;
+            value = sqrtTolerance * da / parabolaIntegral(xMin);
+        }
+    }
+    int segments = (int)std::ceil(0.5f * value / sqrtTolerance);
+    if (!(segments >= 1)) {
+        segments = 1;
+    }
+
+    // параметры t распределены равномерно по интегралу кривизны, а не по t
+    float u0 = parabolaInverseIntegral(a0);
+    float u2 = parabolaInverseIntegral(a2);
+    float uScale = 1.0f / (u2 - u0);
+    size_t base = contour.size();
+    contour.resize(base + segments * 2);
+    float* out = contour.data() + base;
+    for (int i = 1; i < segments; i++) {
+        float u = parabolaInverseIntegral(a0 + (a2 - a0) * i / segments);
+        float t = (u - u0) * uScale;
+        float mt = 1.0f - t;
+        out[(i - 1) * 2] = mt * mt * x0 + 2.0f * mt * t * x1 + t * t * x2;
+        out[(i - 1) * 2 + 1] = mt * mt * y0 + 2.0f * mt * t * y1 + t * t * y2;
+    }
+    out[(segments - 1) * 2] = x2;
+    out[(segments - 1) * 2 + 1] = y2;
+}
+
+// точка и производная кубической кривой в t
+static void evaluateCubic(const float* p, float t, float& x, float& y, float& dx, float& dy) {
+    float mt = 1.0f - t;
+    x = mt * mt * mt * p[0] + 3.0f * mt * mt * t * p[2] + 3.0f * mt * t * t * p[4] + t * t * t * p[6];
+    y = mt * mt * mt * p[1] + 3.0f * mt * mt * t * p[3] + 3.0f * mt * t * t * p[5] + t * t * t * p[7];
+    dx = 3.0f * (mt * mt * (p[2] - p[0]) + 2.0f * mt * t * (p[4] - p[2]) + t * t * (p[6] - p[4]));
+    dy = 3.0f * (mt * mt * (p[3] - p[1]) + 2.0f * mt * t * (p[5] - p[3]) + t * t * (p[7] - p[5]));
+}
+
+// кубическая кривая заменяется квадратичными: 10% допуска на замену, 90% на разбиение
+static void flattenCubic(const float* p, float tolerance, Contour& contour) {
+    float accuracy = 0.1f * tolerance;
+    float sqrtTolerance = std::sqrt(0.9f * tolerance);
+    // ошибка одной квадратичной кривой: |p3 - 3 p2 + 3 p1 - p0| * sqrt(3) / 36
+    float ex = p[6] - 3.0f * p[4] + 3.0f * p[2] - p[0];
+    float ey = p[7] - 3.0f * p[5] + 3.0f * p[3] - p[1];
+    float error = ex * ex + ey * ey;
+    int quads = (int)std::ceil(std::pow(error / (432.0f * accuracy * accuracy), 1.0f / 6.0f));
+    if (quads < 1) {
+        quads = 1;
+    }
+
+    float startX = p[0];
+    float startY = p[1];
+    float startDx = 3.0f * (p[2] - p[0]);
+    float startDy = 3.0f * (p[3] - p[1]);
+    float step = 1.0f / quads;
+    for (int i = 1; i <= quads; i++) {
+        float endX, endY, endDx, endDy;
+        evaluateCubic(p, i * step, endX, endY, endDx, endDy);
+        // управляющие точки участка кубической кривой и лучшая квадратичная для них
+        float c1x = startX + startDx * step / 3.0f;
+        float c1y = startY + startDy * step / 3.0f;
+        float c2x = endX - endDx * step / 3.0f;
+        float c2y = endY - endDy * step / 3.0f;
+        float qx = (3.0f * (c1x + c2x) - startX - endX) * 0.25f;
+        float qy = (3.0f * (c1y + c2y) - startY - endY) * 0.25f;
+        flattenQuad(startX, startY, qx, qy, endX, endY, sqrtTolerance, contour);
+        startX = endX;
+        startY = endY;
+        startDx = endDx;
+        startDy = endDy;
+    }
+}
+
+// число координат, которые команда берет из points
+static int verbFloatCount(unsigned char verb) {
+    switch (verb) {
+    case PATH_MOVE:
+    case PATH_LINE:
+        return 2;
+    case PATH_QUAD:
+        return 4;
+    case PATH_CUBIC:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+void flattenPath(const VectorPath& path, float tolerancePixels, float pixelsPerUnit, std::vector<Contour>& contours) {
+    float tolerance = tolerancePixels / pixelsPerUnit;
+    float sqrtTolerance = std::sqrt(tolerance);
+    size_t used = 0;
+    Contour* contour = nullptr;
+    const float* p = path.points.data();
+
+    for (unsigned char verb : path.verbs) {
+        if (verb == PATH_MOVE) {
+            if (used == contours.size()) {
+                contours.emplace_back();
+            }
+            contour = &contours[used++];
+            contour->clear();
+            contour->push_back(p[0]);
+            contour->push_back(p[1]);
+            p += 2;
+            continue;
+        }
+        // сегмент до первого MOVE не рисуется, но его точки пропускаются
+        if (contour == nullptr) {
+            p += verbFloatCount(verb);
+            continue;
+        }
+        if (verb == PATH_CLOSE) {
+            continue;
+        }
+        // последняя точка контура - начало текущего сегмента
+        float x0 = (*contour)[contour->size() - 2];
+        float y0 = (*contour)[contour->size() - 1];
+        if (verb == PATH_LINE) {
+            contour->push_back(p[0]);
+            contour->push_back(p[1]);
+            p += 2;
+        }
+        else if (verb == PATH_QUAD) {
+            flattenQuad(x0, y0, p[0], p[1], p[2], p[3], sqrtTolerance, *contour);
+            p += 4;
+        }
+        else if (verb == PATH_CUBIC) {
+            const float cubic[8] = { x0, y0, p[0], p[1], p[2], p[3], p[4], p[5] };
+            flattenCubic(cubic, tolerance, *contour);
+            p += 6;
+        }
+    }
+
+    // контуры замкнуты неявно: совпадающая с началом последняя точка не нужна
+    for (size_t i = 0; i < used; i++) {
+        Contour& c = contours[i];
+        size_t n = c.size();
+        if (n >= 4 && c[n - 2] == c[0] && c[n - 1] == c[1]) {
+            c.resize(n - 2);
+        }
+    }
+    contours.resize(used);
+}
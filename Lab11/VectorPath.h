@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <vector>
+
+#include "Triangulator.h"
+
+// векторный путь из отрезков и кривых Безье. Кривые разбиваются на отрезки
+// адаптивно: квадратичная кривая приближается параболой, и число отрезков
+// берется из интеграла ее кривизны (метод Р. Левина), кубическая сначала
+// заменяется несколькими квадратичными. Результат - контуры для
+// triangulatePolygon или addStencilPath.
+
+enum PathVerb {
+    PATH_MOVE,
+    PATH_LINE,
+    PATH_QUAD,
+    PATH_CUBIC,
+    PATH_CLOSE
+};
+
+struct VectorPath {
+    std::vector<unsigned char> verbs;
+    std::vector<float> points;  // пары x, y: по одной на MOVE и LINE, по две на QUAD, по три на CUBIC
+};
+
+// очищает путь, сохраняя выделенную память
+void clearPath(VectorPath& path);
+void pathMoveTo(VectorPath& path, float x, float y);
+void pathLineTo(VectorPath& path, float x, float y);
+void pathQuadTo(VectorPath& path, float controlX, float controlY, float x, float y);
+void pathCubicTo(VectorPath& path, float control1X, float control1Y, float control2X, float control2Y, float x, float y);
+void pathClose(VectorPath& path);
+
+// разбивает путь на контуры с отклонением от кривой не больше tolerancePixels
+// при масштабе pixelsPerUnit. Каждый MOVE начинает новый контур; контуры
+// замкнуты неявно. Память contours переиспользуется: при неизменном числе
+// контуров повторный вызов ничего не выделяет
+void flattenPath(const VectorPath& path, float tolerancePixels, float pixelsPerUnit, std::vector<Contour>& contours);
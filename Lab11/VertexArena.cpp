@@ -0,0 +1,327 @@
+﻿#include "VertexArena.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <iostream>
+
+#include "GLState.h"
+#include "GpuBackend.h"
+
+void initRangeAllocator(RangeAllocator& allocator, size_t capacity) {
+    allocator.capacity = capacity;
+    allocator.used = 0;
+    allocator.freeList.clear();
+    if (capacity > 0) {
+        allocator.freeList.push_back({ 0, capacity });
+    }
+}
+
+bool allocateRange(RangeAllocator& allocator, size_t size, size_t alignment, size_t& offset) {
+    // первый подходящий участок
+    for (size_t i = 0; i < allocator.freeList.size(); i++) {
+        FreeRange& range = allocator.freeList[i];
+        size_t aligned = (range.offset + alignment - 1) / alignment * alignment;
+        size_t padding = aligned - range.offset;
+        if (range.size < size + padding) {
+            continue;
+        }
+
+        offset = aligned;
+        size_t rest = range.size - size - padding;
+        size_t restOffset = aligned + size;
+        if (padding > 0) {
+            range.size = padding;
+            if (rest > 0) {
+                allocator.freeList.insert(allocator.freeList.begin() + i + 1, { restOffset, rest });
+            }
+        }
+        else if (rest > 0) {
+            range.offset = restOffset;
+            range.size = rest;
+        }
+        else {
+            allocator.freeList.erase(allocator.freeList.begin() + i);
+        }
+        allocator.used += size;
+        return true;
+    }
+    return false;
+}
+
+void freeRange(RangeAllocator& allocator, size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    auto it = std::lower_bound(allocator.freeList.begin(), allocator.freeList.end(), offset,
+        [](const FreeRange& range, size_t value) { return range.offset < value; });
+    it = allocator.freeList.insert(it, { offset, size });
+    allocator.used -= size;
+
+    // слияние со следующим участком
+    auto next = it + 1;
+    if (next != allocator.freeList.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        allocator.freeList.erase(next);
+    }
+    // слияние с предыдущим участком
+    if (it != allocator.freeList.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            allocator.freeList.erase(it);
+        }
+    }
+}
+
+size_t largestFreeRange(const RangeAllocator& allocator) {
+    size_t largest = 0;
+    for (const FreeRange& range : allocator.freeList) {
+        largest = std::max(largest, range.size);
+    }
+    return largest;
+}
+
+// атрибуты задает формат арены, точка привязки 0 - вершинный буфер арены
+static void setupArenaVertexArray(VertexArena& arena) {
+    GpuBackend& backend = gpuBackend();
+    backend.setVertexBuffer(arena.VAO, 0, arena.VBO, 0, (int)arena.vertexStride);
+    backend.setElementBuffer(arena.VAO, arena.EBO);
+}
+
+static unsigned int nextArenaGeneration = 1;
+
+void createVertexArena(VertexArena& arena, const VertexFormat& format, size_t vertexCapacity, size_t indexCapacityBytes) {
+    arena.generation = nextArenaGeneration++;
+    arena.format = format;
+    arena.vertexStride = format.stride;
+    initRangeAllocator(arena.vertices, vertexCapacity);
+    initRangeAllocator(arena.indices, indexCapacityBytes);
+
+    GpuBackend& backend = gpuBackend();
+    arena.VBO = backend.createBuffer(vertexCapacity * arena.vertexStride, nullptr, BUFFER_STATIC);
+    arena.EBO = backend.createBuffer(indexCapacityBytes, nullptr, BUFFER_STATIC);
+    arena.VAO = backend.createVertexArray();
+    applyVertexFormat(arena.VAO, 0, format);
+    setupArenaVertexArray(arena);
+}
+
+void destroyVertexArena(VertexArena& arena) {
+    GpuBackend& backend = gpuBackend();
+    backend.deleteVertexArray(arena.VAO);
+    backend.deleteBuffer(arena.VBO);
+    backend.deleteBuffer(arena.EBO);
+    arena.VAO = arena.VBO = arena.EBO = 0;
+    arena.allocations.clear();
+    arena.freeHandles.clear();
+}
+
+// переносит живые участки в новые буферы заданной емкости, упаковывая их подряд
+static void relocateArena(VertexArena& arena, size_t vertexCapacity, size_t indexCapacityBytes) {
+    GpuBackend& backend = gpuBackend();
+    unsigned int vertexBuffer = backend.createBuffer(vertexCapacity * arena.vertexStride, nullptr, BUFFER_STATIC);
+    unsigned int indexBuffer = backend.createBuffer(indexCapacityBytes, nullptr, BUFFER_STATIC);
+
+    std::vector<ArenaHandle> order;
+    for (size_t i = 0; i < arena.allocations.size(); i++) {
+        if (arena.allocations[i].alive) {
+            order.push_back((ArenaHandle)i);
+        }
+    }
+
+    // вершины: сохраняем прежний порядок участков
+    std::sort(order.begin(), order.end(), [&](ArenaHandle a, ArenaHandle b) {
+        return arena.allocations[a].firstVertex < arena.allocations[b].firstVertex;
+    });
+    size_t nextVertex = 0;
+    for (ArenaHandle handle : order) {
+        ArenaAllocation& allocation = arena.allocations[handle];
+        backend.copyBufferSubData(arena.VBO, vertexBuffer,
+            allocation.firstVertex * arena.vertexStride, nextVertex * arena.vertexStride,
+            allocation.vertexCount * arena.vertexStride);
+        allocation.firstVertex = nextVertex;
+        nextVertex += allocation.vertexCount;
+    }
+
+    // индексы
+
+    std::sort(order.begin(), order.end(), [&](ArenaHandle a, ArenaHandle b) {
+        return arena.allocations[a].indexOffset < arena.allocations[b].indexOffset;
+    });
+    size_t nextIndexByte = 0;
+    size_t usedIndexBytes = 0;
+    // выравнивание между участками остается свободным, как и в allocateRange,
+    // чтобы used и список свободных участков вместе давали емкость
+    std::vector<FreeRange> indexPadding;
+    for (ArenaHandle handle : order) {
+        ArenaAllocation& allocation = arena.allocations[handle];
+        if (allocation.indexSize == 0) {
+            continue;
+        }
+        size_t bytes = allocation.indexCount * allocation.indexSize;
+        size_t aligned = (nextIndexByte + allocation.indexSize - 1) / allocation.indexSize * allocation.indexSize;
+        if (aligned > nextIndexByte) {
+            indexPadding.push_back({ nextIndexByte, aligned - nextIndexByte });
+        }
+        nextIndexByte = aligned;
+        backend.copyBufferSubData(arena.EBO, indexBuffer, allocation.indexOffset, nextIndexByte, bytes);
+        allocation.indexOffset = nextIndexByte;
+        nextIndexByte += bytes;
+        usedIndexBytes += bytes;
+    }
+
+    backend.deleteBuffer(arena.VBO);
+    backend.deleteBuffer(arena.EBO);
+    arena.VBO = vertexBuffer;
+    arena.EBO = indexBuffer;
+    arena.generation = nextArenaGeneration++;
+    setupArenaVertexArray(arena);
+
+    // после упаковки свободно все, что лежит за последним участком
+    arena.vertices.capacity = vertexCapacity;
+    arena.vertices.used = nextVertex;
+    arena.vertices.freeList.clear();
+    if (nextVertex < vertexCapacity) {
+        arena.vertices.freeList.push_back({ nextVertex, vertexCapacity - nextVertex });
+    }
+    arena.indices.capacity = indexCapacityBytes;
+    arena.indices.used = usedIndexBytes;
+    arena.indices.freeList = indexPadding;
+    if (nextIndexByte < indexCapacityBytes) {
+        arena.indices.freeList.push_back({ nextIndexByte, indexCapacityBytes - nextIndexByte });
+    }
+    arena.compactions++;
+}
+
+void compactVertexArena(VertexArena& arena) {
+    relocateArena(arena, arena.vertices.capacity, arena.indices.capacity);
+}
+
+// конец индексов после упаковки в relocateArena, вместе с выравниванием между участками
+static size_t packedIndexBytes(const VertexArena& arena) {
+    std::vector<const ArenaAllocation*> order;
+    for (const ArenaAllocation& allocation : arena.allocations) {
+        if (allocation.alive && allocation.indexSize > 0) {
+            order.push_back(&allocation);
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const ArenaAllocation* a, const ArenaAllocation* b) {
+        return a->indexOffset < b->indexOffset;
+    });
+    size_t nextIndexByte = 0;
+    for (const ArenaAllocation* allocation : order) {
+        nextIndexByte = (nextIndexByte + allocation->indexSize - 1) / allocation->indexSize * allocation->indexSize;
+        nextIndexByte += allocation->indexCount * allocation->indexSize;
+    }
+    return nextIndexByte;
+}
+
+// обеспечивает место под участок: уплотнение, если после него свободный хвост
+// буфера вмещает участок, иначе рост буфера вдвое
+static void reserveArenaSpace(VertexArena& arena, size_t vertexCount, size_t indexBytes) {
+    // запас в 4 байта покрывает выравнивание индексов
+    size_t indexNeeded = indexBytes > 0 ? indexBytes + 4 : 0;
+    bool vertexFits = largestFreeRange(arena.vertices) >= vertexCount;
+    bool indexFits = largestFreeRange(arena.indices) >= indexNeeded;
+    if (vertexFits && indexFits) {
+        return;
+    }
+
+    size_t vertexCapacity = arena.vertices.capacity;
+    size_t indexCapacity = arena.indices.capacity;
+    while (vertexCapacity - arena.vertices.used < vertexCount) {
+        vertexCapacity = std::max<size_t>(vertexCapacity * 2, 1024);
+    }
+    // выравнивание между участками остается свободным, но в хвост не попадает
+    size_t indexEnd = packedIndexBytes(arena);
+    while (indexCapacity - indexEnd < indexNeeded) {
+        indexCapacity = std::max<size_t>(indexCapacity * 2, 4096);
+    }
+    relocateArena(arena, vertexCapacity, indexCapacity);
+}
+
+ArenaHandle arenaAllocate(VertexArena& arena, const void* vertices, size_t vertexCount,
+    const void* indices, size_t indexCount, int indexSize) {
+    if (vertexCount == 0) {
+        return INVALID_ARENA_HANDLE;
+    }
+    if (!indices) {
+        indexCount = 0;
+        indexSize = 0;
+    }
+    size_t indexBytes = indexCount * indexSize;
+
+    ArenaAllocation allocation;
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+    allocation.indexSize = indexSize;
+    allocation.alive = true;
+
+    bool placed = allocateRange(arena.vertices, vertexCount, 1, allocation.firstVertex);
+    if (placed && indexBytes > 0) {
+        placed = allocateRange(arena.indices, indexBytes, indexSize, allocation.indexOffset);
+        if (!placed) {
+            freeRange(arena.vertices, allocation.firstVertex, vertexCount);
+        }
+    }
+    if (!placed) {
+        reserveArenaSpace(arena, vertexCount, indexBytes);
+        placed = allocateRange(arena.vertices, vertexCount, 1, allocation.firstVertex);
+        if (placed && indexBytes > 0) {
+            placed = allocateRange(arena.indices, indexBytes, indexSize, allocation.indexOffset);
+            if (!placed) {
+                freeRange(arena.vertices, allocation.firstVertex, vertexCount);
+            }
+        }
+        if (!placed) {
+            std::cout << "Vertex arena: out of space" << std::endl;
+            return INVALID_ARENA_HANDLE;
+        }
+    }
+
+    GpuBackend& backend = gpuBackend();
+    backend.bufferSubData(arena.VBO, allocation.firstVertex * arena.vertexStride,
+        vertexCount * arena.vertexStride, vertices);
+    if (indexBytes > 0) {
+        backend.bufferSubData(arena.EBO, allocation.indexOffset, indexBytes, indices);
+    }
+
+    ArenaHandle handle;
+    if (!arena.freeHandles.empty()) {
+        handle = arena.freeHandles.back();
+        arena.freeHandles.pop_back();
+        arena.allocations[handle] = allocation;
+    }
+    else {
+        handle = (ArenaHandle)arena.allocations.size();
+        arena.allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void arenaFree(VertexArena& arena, ArenaHandle handle) {
+    if (handle < 0 || handle >= (ArenaHandle)arena.allocations.size()) {
+        return;
+    }
+    ArenaAllocation& allocation = arena.allocations[handle];
+    if (!allocation.alive) {
+        return;
+    }
+    freeRange(arena.vertices, allocation.firstVertex, allocation.vertexCount);
+    freeRange(arena.indices, allocation.indexOffset, allocation.indexCount * allocation.indexSize);
+    allocation.alive = false;
+    arena.freeHandles.push_back(handle);
+}
+
+void bindVertexArena(const VertexArena& arena) {
+    stateBindVertexArray(arena.VAO);
+}
+
+void drawArenaRange(const VertexArena& arena, ArenaHandle handle) {
+    const ArenaAllocation& allocation = arena.allocations[handle];
+    if (allocation.indexSize == 0) {
+        glDrawArrays(GL_TRIANGLES, (GLint)allocation.firstVertex, (GLsizei)allocation.vertexCount);
+        return;
+    }
+    GLenum type = allocation.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)allocation.indexCount, type,
+        (void*)allocation.indexOffset, (GLint)allocation.firstVertex);
+}
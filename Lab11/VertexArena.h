@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "VertexFormat.h"
+
+// свободный участок буфера
+struct FreeRange {
+    size_t offset;
+    size_t size;
+};
+
+// распределитель смещений внутри буфера фиксированной емкости:
+// список свободных участков упорядочен по смещению, соседние участки сливаются
+struct RangeAllocator {
+    size_t capacity = 0;
+    size_t used = 0;
+    std::vector<FreeRange> freeList;
+};
+
+void initRangeAllocator(RangeAllocator& allocator, size_t capacity);
+bool allocateRange(RangeAllocator& allocator, size_t size, size_t alignment, size_t& offset);
+void freeRange(RangeAllocator& allocator, size_t offset, size_t size);
+size_t largestFreeRange(const RangeAllocator& allocator);
+
+// участок общего буфера, занятый одной фигурой
+struct ArenaAllocation {
+    size_t firstVertex = 0;  // в вершинах
+    size_t vertexCount = 0;
+    size_t indexOffset = 0;  // в байтах
+    size_t indexCount = 0;
+    int indexSize = 0;       // 0 - без индексов, 2 или 4 байта
+    bool alive = false;
+};
+
+typedef int ArenaHandle;
+const ArenaHandle INVALID_ARENA_HANDLE = -1;
+
+// один большой вершинный и индексный буфер под один VAO;
+// фигуры лежат в нем участками и рисуются со смещением first/baseVertex
+struct VertexArena {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    VertexFormat format;      // позиция vec2 в выбранной кодировке
+    size_t vertexStride = 0;  // format.stride
+    RangeAllocator vertices;  // единица - вершина
+    RangeAllocator indices;   // единица - байт
+    std::vector<ArenaAllocation> allocations;
+    std::vector<ArenaHandle> freeHandles;
+    int compactions = 0;
+    // меняется при каждой смене буферов (создание, уплотнение, рост) и не
+    // повторяется между аренами; имена GL после удаления могут выдаваться заново
+    unsigned int generation = 0;
+};
+
+// vertices в arenaAllocate должны быть уже в формате format
+void createVertexArena(VertexArena& arena, const VertexFormat& format, size_t vertexCapacity, size_t indexCapacityBytes);
+void destroyVertexArena(VertexArena& arena);
+
+// копирует вершины (и индексы, если они есть) в свободный участок арены;
+// при нехватке места арена сначала уплотняется, затем растет
+ArenaHandle arenaAllocate(VertexArena& arena, const void* vertices, size_t vertexCount,
+    const void* indices = nullptr, size_t indexCount = 0, int indexSize = 0);
+void arenaFree(VertexArena& arena, ArenaHandle handle);
+
+// сдвигает живые участки к началу буферов, убирая дыры
+void compactVertexArena(VertexArena& arena);
+
+void bindVertexArena(const VertexArena& arena);
+// рисует участок, арена уже должна быть привязана
+void drawArenaRange(const VertexArena& arena, ArenaHandle handle);
@@ -0,0 +1,135 @@
+﻿#include "VertexFormat.h"
+#include <GL/glew.h>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
+
+#include "GpuBackend.h"
+
+static size_t encodingSize(AttributeEncoding encoding) {
+    switch (encoding) {
+    case ENCODING_HALF:
+    case ENCODING_SNORM16:
+        return 2;
+    case ENCODING_UNORM8:
+        return 1;
+    default:
+        return 4;
+    }
+}
+
+void addFormatAttribute(VertexFormat& format, unsigned int location, int components, AttributeEncoding encoding) {
+    if (format.attributeCount == MAX_FORMAT_ATTRIBUTES) {
+        return;
+    }
+    VertexAttributeLayout& attribute = format.attributes[format.attributeCount++];
+    attribute.location = location;
+    attribute.components = components;
+    attribute.encoding = encoding;
+    attribute.offset = (unsigned int)format.stride;
+    size_t size = components * encodingSize(encoding);
+    format.stride += (size + 3) & ~(size_t)3;
+}
+
+VertexFormat positionFormat(AttributeEncoding encoding) {
+    VertexFormat format;
+    addFormatAttribute(format, 0, 2, encoding);
+    return format;
+}
+
+void applyVertexFormat(unsigned int vao, unsigned int binding, const VertexFormat& format) {
+    GpuBackend& backend = gpuBackend();
+    for (int i = 0; i < format.attributeCount; i++) {
+        const VertexAttributeLayout& attribute = format.attributes[i];
+        switch (attribute.encoding) {
+        case ENCODING_HALF:
+            backend.setVertexAttribute(vao, attribute.location, binding, attribute.components, GL_HALF_FLOAT, false, attribute.offset);
+            break;
+        case ENCODING_SNORM16:
+            backend.setVertexAttribute(vao, attribute.location, binding, attribute.components, GL_SHORT, true, attribute.offset);
+            break;
+        case ENCODING_UNORM8:
+            backend.setVertexAttribute(vao, attribute.location, binding, attribute.components, GL_UNSIGNED_BYTE, true, attribute.offset);
+            break;
+        default:
+            backend.setVertexAttribute(vao, attribute.location, binding, attribute.components, GL_FLOAT, false, attribute.offset);
+            break;
+        }
+    }
+}
+
+// одна компонента в memory; возвращает значение, которое увидит шейдер
+static float encodeComponent(AttributeEncoding encoding, float value, unsigned char* memory) {
+    switch (encoding) {
+    case ENCODING_HALF: {
+        glm::uint16 packed = glm::packHalf1x16(value);
+        memcpy(memory, &packed, sizeof(packed));
+        return glm::unpackHalf1x16(packed);
+    }
+    case ENCODING_SNORM16: {
+        glm::uint16 packed = glm::packSnorm1x16(value);
+        memcpy(memory, &packed, sizeof(packed));
+        return glm::unpackSnorm1x16(packed);
+    }
+    case ENCODING_UNORM8: {
+        glm::uint8 packed = glm::packUnorm1x8(value);
+        *memory = packed;
+        return glm::unpackUnorm1x8(packed);
+    }
+    default:
+        memcpy(memory, &value, sizeof(value));
+        return value;
+    }
+}
+
+void encodeAttribute(const VertexFormat& format, int attribute, const float* values, int count, void* out) {
+    const VertexAttributeLayout& layout = format.attributes[attribute];
+    size_t componentSize = encodingSize(layout.encoding);
+    unsigned char* vertex = (unsigned char*)out + layout.offset;
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < layout.components; c++) {
+            encodeComponent(layout.encoding, values[i * layout.components + c], vertex + c * componentSize);
+        }
+        vertex += format.stride;
+    }
+}
+
+float encodingError(AttributeEncoding encoding, const float* values, int count) {
+    float maxError = 0.0f;
+    unsigned char scratch[4];
+    for (int i = 0; i < count; i++) {
+        float error = std::fabs(encodeComponent(encoding, values[i], scratch) - values[i]);
+        maxError = error > maxError ? error : maxError;
+    }
+    return maxError;
+}
+
+uint32_t packColorUnorm8(float r, float g, float b, float a) {
+    return glm::packUnorm4x8(glm::vec4(r, g, b, a));
+}
+
+const char* encodingName(AttributeEncoding encoding) {
+    switch (encoding) {
+    case ENCODING_FLOAT32:
+        return "float";
+    case ENCODING_HALF:
+        return "half";
+    case ENCODING_SNORM16:
+        return "snorm16";
+    case ENCODING_UNORM8:
+        return "unorm8";
+    default:
+        return "unknown";
+    }
+}
+
+bool parseEncoding(const std::string& name, AttributeEncoding& encoding) {
+    for (int i = 0; i < ENCODING_COUNT; i++) {
+        if (name == encodingName((AttributeEncoding)i)) {
+            encoding = (AttributeEncoding)i;
+            return true;
+        }
+    }
+    return false;
+}
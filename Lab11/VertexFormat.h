@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// сжатые форматы вершин: позиции в snorm16 или half вместо float, цвета в unorm8.
+// Упаковка идет функциями glm/gtc/packing.hpp, атрибуты VAO строятся по
+// описанию формата, так что шейдеры по-прежнему получают vec2 и vec4
+
+enum AttributeEncoding {
+    ENCODING_FLOAT32,  // 4 байта на компонент
+    ENCODING_HALF,     // 2 байта, 11 значащих бит
+    ENCODING_SNORM16,  // 2 байта, [-1, 1] с шагом 1/32767
+    ENCODING_UNORM8,   // 1 байт, [0, 1] с шагом 1/255
+    ENCODING_COUNT
+};
+
+const int MAX_FORMAT_ATTRIBUTES = 4;
+
+struct VertexAttributeLayout {
+    unsigned int location = 0;
+    int components = 0;
+    AttributeEncoding encoding = ENCODING_FLOAT32;
+    unsigned int offset = 0;
+};
+
+struct VertexFormat {
+    VertexAttributeLayout attributes[MAX_FORMAT_ATTRIBUTES];
+    int attributeCount = 0;
+    size_t stride = 0;
+};
+
+// добавляет атрибут в конец вершины; смещения и шаг выравниваются на 4 байта
+void addFormatAttribute(VertexFormat& format, unsigned int location, int components, AttributeEncoding encoding);
+
+// формат из одной позиции vec2 в location 0
+VertexFormat positionFormat(AttributeEncoding encoding);
+
+// задает все атрибуты формата в vao для точки привязки binding
+void applyVertexFormat(unsigned int vao, unsigned int binding, const VertexFormat& format);
+
+// пишет атрибут attribute для count вершин в out с шагом format.stride;
+// values - по components чисел на вершину подряд
+void encodeAttribute(const VertexFormat& format, int attribute, const float* values, int count, void* out);
+
+// наибольшая ошибка значений после упаковки и распаковки
+float encodingError(AttributeEncoding encoding, const float* values, int count);
+
+// цвет 0..1 в четыре байта r, g, b, a (packUnorm4x8)
+uint32_t packColorUnorm8(float r, float g, float b, float a);
+
+const char* encodingName(AttributeEncoding encoding);
+bool parseEncoding(const std::string& name, AttributeEncoding& encoding);
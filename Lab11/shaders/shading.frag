@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+#if defined(VERTEX_COLOR)
+in vec4 vertexColor;
+#elif defined(UNIFORM_COLOR)
+layout (std140) uniform DrawConstants {
+    vec4 uColor;
+    vec4 uTransform;
+};
+#endif
+void main() {
+#if defined(VERTEX_COLOR)
+    FragColor = vertexColor;
+#elif defined(UNIFORM_COLOR)
+    FragColor = uColor;
+#else
+    FragColor = vec4(1.0, 0.2, 1.0, 1.0);
+#endif
+}
@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+#ifdef VERTEX_COLOR
+layout (location = 1) in vec4 aColor;
+out vec4 vertexColor;
+#endif
+#ifdef DRAW_TRANSFORM
+layout (std140) uniform FrameConstants {
+    vec4 uViewport;
+    float uTime;
+};
+layout (std140) uniform DrawConstants {
+    vec4 uColor;
+    vec4 uTransform;
+};
+#endif
+void main() {
+#ifdef DRAW_TRANSFORM
+    // поворот и масштаб фигуры без растяжения вдоль длинной стороны окна
+    float c = cos(uTransform.w);
+    float s = sin(uTransform.w);
+    vec2 local = uTransform.z * vec2(c * aPos.x - s * aPos.y, s * aPos.x + c * aPos.y);
+    vec2 aspect = vec2(min(1.0, uViewport.y * uViewport.z), min(1.0, uViewport.x * uViewport.w));
+    gl_Position = vec4(uTransform.xy + local * aspect, 0.0, 1.0);
+#else
+    gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
+#endif
+#ifdef VERTEX_COLOR
+    vertexColor = aColor;
+#endif
+}